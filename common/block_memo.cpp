@@ -0,0 +1,95 @@
+#include "block_memo.h"
+
+#include <functional>
+#include <sstream>
+
+#include "frontends/p4/toP4/toP4.h"
+#include "ir/visitor.h"
+
+namespace P4::ToZ3 {
+
+namespace {
+
+// Collects every name a node refers to. Local names that shadow a top-level
+// declaration are collected as well, which only makes the key conservative.
+class CollectRefs : public Inspector {
+ private:
+    std::set<cstring> *refs;
+    void postorder(const IR::Path *path) override { refs->insert(path->name.name); }
+
+ public:
+    explicit CollectRefs(std::set<cstring> *refs) : refs(refs) {}
+};
+
+size_t hash_node(const IR::Node *node) {
+    std::stringstream node_stream;
+    P4::ToP4 to_p4(&node_stream, false);
+    node->apply(to_p4);
+    return std::hash<std::string>{}(node_stream.str());
+}
+
+}  // namespace
+
+void BlockMemo::set_program(const IR::P4Program *program) {
+    decls.clear();
+    for (const auto *node : program->objects) {
+        // Unnamed declarations are filed under the empty name, which is part
+        // of every key.
+        cstring name = ""_cs;
+        if (const auto *decl = node->to<IR::IDeclaration>()) {
+            name = decl->getName().name;
+        }
+        auto &info = decls[name];
+        info.hashes.push_back(hash_node(node));
+        node->apply(CollectRefs(&info.refs));
+    }
+}
+
+std::string BlockMemo::get_block_key(const IR::ConstructorCallExpression *cce,
+                                     cstring param_name, const IR::Type *param_type) const {
+    std::set<cstring> closure = {""_cs};
+    std::vector<cstring> worklist = {""_cs};
+    std::set<cstring> block_refs;
+    cce->apply(CollectRefs(&block_refs));
+    param_type->apply(CollectRefs(&block_refs));
+    worklist.insert(worklist.end(), block_refs.begin(), block_refs.end());
+    closure.insert(block_refs.begin(), block_refs.end());
+    while (!worklist.empty()) {
+        auto name = worklist.back();
+        worklist.pop_back();
+        auto it = decls.find(name);
+        if (it == decls.end()) {
+            continue;
+        }
+        for (auto ref : it->second.refs) {
+            if (closure.insert(ref).second) {
+                worklist.push_back(ref);
+            }
+        }
+    }
+    std::stringstream key;
+    key << param_name << ":" << hash_node(cce) << ":" << hash_node(param_type);
+    for (auto name : closure) {
+        auto it = decls.find(name);
+        if (it == decls.end()) {
+            continue;
+        }
+        key << ";" << name;
+        for (auto hash : it->second.hashes) {
+            key << ":" << hash;
+        }
+    }
+    return key.str();
+}
+
+const ArchBlockResult *BlockMemo::lookup(const std::string &key) {
+    auto it = results.find(key);
+    if (it == results.end()) {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    return &it->second;
+}
+
+}  // namespace P4::ToZ3
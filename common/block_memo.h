@@ -0,0 +1,52 @@
+#ifndef TOZ3_COMMON_BLOCK_MEMO_H_
+#define TOZ3_COMMON_BLOCK_MEMO_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../contrib/z3/z3++.h"
+#include "ir/ir.h"
+#include "lib/cstring.h"
+
+namespace P4::ToZ3 {
+
+using ArchBlockResult = std::vector<std::pair<cstring, z3::expr>>;
+
+// Memoizes the symbolic results of architecture blocks across the passes of
+// a program. A block is keyed by a structural hash of its declaration and of
+// every top-level declaration (controls, parsers, actions, functions, types)
+// it transitively refers to. All passes must be interpreted in one context.
+class BlockMemo {
+ private:
+    struct DeclInfo {
+        std::vector<size_t> hashes;
+        std::set<cstring> refs;
+    };
+    // The top-level declarations of the current program by name.
+    std::map<cstring, DeclInfo> decls;
+    std::map<std::string, ArchBlockResult> results;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+ public:
+    // Index the top-level declarations of the program that is interpreted next.
+    void set_program(const IR::P4Program *program);
+    // The key of the block constructed by cce for the given package parameter.
+    std::string get_block_key(const IR::ConstructorCallExpression *cce, cstring param_name,
+                              const IR::Type *param_type) const;
+    const ArchBlockResult *lookup(const std::string &key);
+    void insert(const std::string &key, const ArchBlockResult &result) {
+        results.insert_or_assign(key, result);
+    }
+    uint64_t get_hits() const { return hits; }
+    uint64_t get_misses() const { return misses; }
+};
+
+}  // namespace P4::ToZ3
+
+#endif  // TOZ3_COMMON_BLOCK_MEMO_H_
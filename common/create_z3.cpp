@@ -1,8 +1,18 @@
 #include "create_z3.h"
 
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdlib>
 #include <functional>
+#include <iostream>
+#include <iterator>
 #include <map>
+#include <optional>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -70,16 +80,27 @@ std::map<cstring, const IR::Type *> specialize_arch_blocks(const IR::Type *src_t
     P4C_UNIMPLEMENTED("Unsupported cast from type %s to type %s", src_type, dest_type);
 }
 
-std::vector<std::pair<cstring, z3::expr>> run_arch_block(Z3Visitor *visitor,
-                                                         const IR::ConstructorCallExpression *cce,
-                                                         const IR::Type *param_type,
-                                                         cstring param_name,
-                                                         const IR::TypeParameters &meta_params) {
+// An architecture block whose apply function is ready to be interpreted.
+struct ArchBlock {
+    cstring param_name;
+    const IR::ParameterList *params;
+    FunOrMethod fun_call;
+    std::string memo_key;
+    // Type parameters the block binds, added to the state right before it
+    // runs so that earlier blocks still see the state they would in order.
+    std::vector<std::pair<cstring, const IR::Type *>> new_types;
+};
+
+std::optional<ArchBlock> prepare_arch_block(Z3Visitor *visitor,
+                                            const IR::ConstructorCallExpression *cce,
+                                            const IR::Type *param_type, cstring param_name,
+                                            const IR::TypeParameters &meta_params) {
     auto *state = visitor->get_state();
 
     visitor->visit(cce);
     const IR::ParameterList *params = nullptr;
     FunOrMethod fun_call = nullptr;
+    std::vector<std::pair<cstring, const IR::Type *>> new_types;
     // TODO: Refactor all of this into a separate pass
     const auto *constructed_expr = state->get_expr_result()->cast_allocate(param_type);
     const auto *resolved_type = constructed_expr->get_p4_type();
@@ -89,7 +110,7 @@ std::vector<std::pair<cstring, z3::expr>> run_arch_block(Z3Visitor *visitor,
             for (const auto &mapped_type : type_mapping) {
                 if (meta_params.getDeclByName(mapped_type.first) != nullptr &&
                     visitor->get_state()->check_for_type(mapped_type.first) == nullptr) {
-                    visitor->get_state()->add_type(mapped_type.first, mapped_type.second);
+                    new_types.emplace_back(mapped_type.first, mapped_type.second);
                 }
             }
             params = c->getApplyParameters();
@@ -97,12 +118,12 @@ std::vector<std::pair<cstring, z3::expr>> run_arch_block(Z3Visitor *visitor,
             fun_call = ctrl_instance->get_function(apply_name);
         } else if (const auto *p = resolved_type->to<IR::P4Parser>()) {
             P4::warning("Ignoring parser output.");
-            return {};
+            return std::nullopt;
             auto type_mapping = specialize_arch_blocks(param_type, resolved_type);
             for (const auto &mapped_type : type_mapping) {
                 if (meta_params.getDeclByName(mapped_type.first) != nullptr &&
                     visitor->get_state()->check_for_type(mapped_type.first) == nullptr) {
-                    visitor->get_state()->add_type(mapped_type.first, mapped_type.second);
+                    new_types.emplace_back(mapped_type.first, mapped_type.second);
                 }
             }
             params = p->getApplyParameters();
@@ -114,20 +135,25 @@ std::vector<std::pair<cstring, z3::expr>> run_arch_block(Z3Visitor *visitor,
         }
     } else if (constructed_expr->is<ExternInstance>()) {
         // Not sure what to do here yet...
-        return {};
+        return std::nullopt;
     } else {
         P4C_UNIMPLEMENTED("Type Declaration %s of type %s not supported.", resolved_type,
                           resolved_type->node_type_name());
     }
+    return ArchBlock{param_name, params, fun_call, {}, new_types};
+}
+
+ArchBlockResult run_arch_block(Z3Visitor *visitor, const ArchBlock &block) {
+    auto *state = visitor->get_state();
     // INITIALIZE
     // TODO: Simplify this
     state->push_scope();
 
     std::vector<cstring> param_names;
     IR::Vector<IR::Argument> synthesized_args;
-    for (const auto *param : *params) {
+    for (const auto *param : *block.params) {
         const auto *par_type = state->resolve_type(param->type);
-        cstring instance_name = param_name + "." + param->name.name;
+        cstring instance_name = block.param_name + "." + param->name.name;
         if (!par_type->is<IR::Type_Package>()) {
             auto *var = state->gen_instance(instance_name, par_type);
             if (param->direction != IR::Direction::Out) {
@@ -143,7 +169,7 @@ std::vector<std::pair<cstring, z3::expr>> run_arch_block(Z3Visitor *visitor,
         synthesized_args.push_back(arg);
     }
     // Call the apply function of the pipeline
-    if (const auto *function = boost::get<P4Z3Function>(&fun_call)) {
+    if (const auto *function = boost::get<P4Z3Function>(&block.fun_call)) {
         (*function)(visitor, &synthesized_args);
     } else {
         BUG("Unexpected main function.");
@@ -152,7 +178,7 @@ std::vector<std::pair<cstring, z3::expr>> run_arch_block(Z3Visitor *visitor,
     state->merge_exit_states();
 
     // COLLECT
-    std::vector<std::pair<cstring, z3::expr>> state_vars;
+    ArchBlockResult state_vars;
     for (auto param_name : param_names) {
         const auto *var = state->get_var(param_name);
         if (const auto *z3_var = var->to<NumericVal>()) {
@@ -173,9 +199,149 @@ std::vector<std::pair<cstring, z3::expr>> run_arch_block(Z3Visitor *visitor,
     return state_vars;
 }
 
-MainResult create_state(Z3Visitor *visitor, const ParamInfo &param_info) {
+// Results cross the process boundary as SMT-LIB, preceded by the names of
+// the state variables.
+std::string serialize_result(z3::context *ctx, const ArchBlockResult &result) {
+    std::stringstream out;
+    z3::solver dump(*ctx);
+    out << result.size() << "\n";
+    for (size_t idx = 0; idx < result.size(); ++idx) {
+        const auto &var = result[idx];
+        out << var.first << "\n";
+        auto result_const =
+            ctx->constant(("result_" + std::to_string(idx)).c_str(), var.second.get_sort());
+        dump.add(result_const == var.second);
+    }
+    out << dump.to_smt2();
+    return out.str();
+}
+
+std::optional<ArchBlockResult> deserialize_result(z3::context *ctx, const std::string &str) {
+    std::stringstream in(str);
+    size_t num_vars = 0;
+    if (!(in >> num_vars)) {
+        return std::nullopt;
+    }
+    in.ignore();
+    std::vector<cstring> names;
+    std::string name;
+    for (size_t idx = 0; idx < num_vars && std::getline(in, name); ++idx) {
+        names.emplace_back(name);
+    }
+    std::string smt((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    try {
+        auto assertions = ctx->parse_string(smt.c_str());
+        if (names.size() != num_vars || assertions.size() != num_vars) {
+            return std::nullopt;
+        }
+        ArchBlockResult result;
+        for (size_t idx = 0; idx < num_vars; ++idx) {
+            result.emplace_back(names[idx], assertions[static_cast<int>(idx)].arg(1));
+        }
+        return result;
+    } catch (z3::exception &) {
+        return std::nullopt;
+    }
+}
+
+std::string read_all(int fd) {
+    std::string data;
+    std::array<char, 4096> buf{};
+    ssize_t len = 0;
+    while ((len = read(fd, buf.data(), buf.size())) > 0) {
+        data.append(buf.data(), len);
+    }
+    return data;
+}
+
+// Interprets each block in a forked worker, at most jobs at a time. Workers
+// inherit the interpreter state, so they need neither a copy of the state nor
+// a context of their own. Blocks whose worker failed yield no result.
+std::vector<std::optional<ArchBlockResult>> run_arch_blocks_forked(
+    Z3Visitor *visitor, const std::vector<ArchBlock> &blocks, uint64_t jobs) {
+    auto *ctx = visitor->get_state()->get_z3_ctx();
+    std::vector<std::optional<ArchBlockResult>> results(blocks.size());
+    for (size_t batch = 0; batch < blocks.size(); batch += jobs) {
+        auto batch_end = std::min<size_t>(batch + jobs, blocks.size());
+        std::vector<std::pair<pid_t, int>> workers;
+        std::cout.flush();
+        std::cerr.flush();
+        for (size_t idx = batch; idx < batch_end; ++idx) {
+            std::array<int, 2> fds{};
+            if (pipe(fds.data()) != 0) {
+                workers.emplace_back(-1, -1);
+                continue;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                int exit_code = EXIT_SUCCESS;
+                try {
+                    auto data = serialize_result(ctx, run_arch_block(visitor, blocks[idx]));
+                    size_t written = 0;
+                    while (written < data.size()) {
+                        auto len = write(fds[1], data.data() + written, data.size() - written);
+                        if (len <= 0) {
+                            exit_code = EXIT_FAILURE;
+                            break;
+                        }
+                        written += len;
+                    }
+                } catch (...) {
+                    exit_code = EXIT_FAILURE;
+                }
+                close(fds[1]);
+                _exit(exit_code);
+            }
+            close(fds[1]);
+            if (pid < 0) {
+                close(fds[0]);
+                workers.emplace_back(-1, -1);
+                continue;
+            }
+            workers.emplace_back(pid, fds[0]);
+        }
+        for (size_t idx = batch; idx < batch_end; ++idx) {
+            auto worker = workers[idx - batch];
+            if (worker.first < 0) {
+                continue;
+            }
+            auto data = read_all(worker.second);
+            close(worker.second);
+            int status = 0;
+            waitpid(worker.first, &status, 0);
+            if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) {
+                results[idx] = deserialize_result(ctx, data);
+            }
+        }
+    }
+    return results;
+}
+
+MainResult create_state(Z3Visitor *visitor, const ParamInfo &param_info, BlockMemo *memo,
+                        uint64_t jobs) {
     MainResult merged_vec;
     size_t idx = 0;
+    // Blocks that still need to be interpreted. They run on fresh inputs and
+    // do not depend on each other, only on the types bound before them.
+    std::vector<ArchBlock> pending_blocks;
+    auto run_pending = [&]() {
+        std::vector<std::optional<ArchBlockResult>> results(pending_blocks.size());
+        if (jobs > 1 && pending_blocks.size() > 1) {
+            results = run_arch_blocks_forked(visitor, pending_blocks, jobs);
+        }
+        for (size_t block_idx = 0; block_idx < pending_blocks.size(); ++block_idx) {
+            const auto &block = pending_blocks[block_idx];
+            if (!results[block_idx].has_value()) {
+                results[block_idx] = run_arch_block(visitor, block);
+            }
+            merged_vec[block.param_name].first = *results[block_idx];
+            if (memo != nullptr) {
+                memo->insert(block.memo_key, *results[block_idx]);
+            }
+        }
+        pending_blocks.clear();
+    };
 
     ordered_map<const IR::Parameter *, const IR::Expression *> param_mapping;
     for (const auto &param : param_info.params) {
@@ -203,14 +369,38 @@ MainResult create_state(Z3Visitor *visitor, const ParamInfo &param_info) {
         }
         CHECK_NULL(arg_expr);
         if (const auto *cce = arg_expr->to<IR::ConstructorCallExpression>()) {
-            auto state_result =
-                run_arch_block(visitor, cce, visitor->get_state()->resolve_type(param_type),
-                               param_name, param_info.type_params);
-            merged_vec.insert({param_name, {state_result, param_type}});
+            const auto *resolved_type = visitor->get_state()->resolve_type(param_type);
+            auto block = prepare_arch_block(visitor, cce, resolved_type, param_name,
+                                            param_info.type_params);
+            merged_vec.insert({param_name, {{}, param_type}});
+            if (!block.has_value()) {
+                continue;
+            }
+            // Blocks before this one must not see the types it binds.
+            if (!block->new_types.empty()) {
+                run_pending();
+                for (const auto &new_type : block->new_types) {
+                    visitor->get_state()->add_type(new_type.first, new_type.second);
+                }
+            }
+            // Reuse the result of an identical block interpreted in a previous pass.
+            if (memo != nullptr) {
+                block->memo_key = memo->get_block_key(cce, param_name, resolved_type);
+                if (const auto *memo_result = memo->lookup(block->memo_key)) {
+                    merged_vec[param_name].first = *memo_result;
+                    continue;
+                }
+            }
+            pending_blocks.push_back(*block);
+            if (jobs <= 1) {
+                run_pending();
+            }
         } else if (const auto *path = arg_expr->to<IR::PathExpression>()) {
+            // Nested packages bind types of their own, so keep them in order.
+            run_pending();
             const auto *decl = visitor->get_state()->get_static_decl(path->path->name.name);
             const auto *di = decl->get_decl()->checkedTo<IR::Declaration_Instance>();
-            auto sub_results = gen_state_from_instance(visitor, di);
+            auto sub_results = gen_state_from_instance(visitor, di, memo, jobs);
             for (const auto &sub_result : sub_results) {
                 auto merged_name = param_name + sub_result.first;
                 auto variables = sub_result.second;
@@ -230,10 +420,12 @@ MainResult create_state(Z3Visitor *visitor, const ParamInfo &param_info) {
                               arg_expr->node_type_name());
         }
     }
+    run_pending();
     return merged_vec;
 }
 
-MainResult gen_state_from_instance(Z3Visitor *visitor, const IR::Declaration_Instance *di) {
+MainResult gen_state_from_instance(Z3Visitor *visitor, const IR::Declaration_Instance *di,
+                                   BlockMemo *memo, uint64_t jobs) {
     const IR::Type *resolved_type = visitor->get_state()->resolve_type(di->type);
     const IR::ParameterList *params = nullptr;
     const IR::TypeParameters *type_params = nullptr;
@@ -251,7 +443,7 @@ MainResult gen_state_from_instance(Z3Visitor *visitor, const IR::Declaration_Ins
                           resolved_type->node_type_name());
     }
     ParamInfo param_info{*params, *di->arguments, *type_params, {}};
-    return create_state(visitor, param_info);
+    return create_state(visitor, param_info, memo, jobs);
 }
 
 const IR::Declaration_Instance *get_main_decl(P4State *state) {
@@ -1,6 +1,9 @@
 #ifndef TOZ3_COMMON_CREATE_Z3_H_
 #define TOZ3_COMMON_CREATE_Z3_H_
 
+#include <cstdint>
+
+#include "block_memo.h"
 #include "ir/ir.h"
 #include "toz3/common/state.h"
 #include "toz3/common/type_base.h"
@@ -8,7 +11,11 @@
 
 namespace P4::ToZ3 {
 
-MainResult gen_state_from_instance(Z3Visitor *visitor, const IR::Declaration_Instance *di);
+// Interprets the architecture blocks of a package instance. Blocks found in
+// the memo are not interpreted again. With more than one job, the blocks are
+// interpreted concurrently in forked workers.
+MainResult gen_state_from_instance(Z3Visitor *visitor, const IR::Declaration_Instance *di,
+                                   BlockMemo *memo = nullptr, uint64_t jobs = 1);
 const IR::Declaration_Instance *get_main_decl(P4State *state);
 
 }  // namespace P4::ToZ3
@@ -26,7 +26,7 @@ bool Z3Visitor::preorder(const IR::ArrayIndex *ai) {
               "Access index of type %s not "
               "implemented for indexable types.",
               index->get_static_type());
-    const auto expr = val_container->get_val()->simplify();
+    const auto expr = state->simplify(*val_container->get_val());
     visit(ai->left);
     const auto *indexable_class = state->get_expr_result<IndexableInstance>();
     state->set_expr_result(indexable_class->get_member(expr));
@@ -254,7 +254,7 @@ bool Z3Visitor::preorder(const IR::BXor *expr) {
 bool Z3Visitor::preorder(const IR::LAnd *expr) {
     visit(expr->left);
     auto *left = state->copy_expr_result<Z3Bitvector>();
-    if (left->get_val()->simplify().is_false() || state->has_exited()) {
+    if (state->simplify(*left->get_val()).is_false() || state->has_exited()) {
         state->set_expr_result(left);
         return false;
     }
@@ -273,7 +273,7 @@ bool Z3Visitor::preorder(const IR::LAnd *expr) {
 bool Z3Visitor::preorder(const IR::LOr *expr) {
     visit(expr->left);
     auto *left = state->copy_expr_result<Z3Bitvector>();
-    if (left->get_val()->simplify().is_true() || state->has_exited()) {
+    if (state->simplify(*left->get_val()).is_true() || state->has_exited()) {
         state->set_expr_result(left);
         return false;
     }
@@ -324,7 +324,7 @@ bool Z3Visitor::preorder(const IR::Cast *c) {
 bool Z3Visitor::preorder(const IR::Mux *m) {
     // Resolve condition first.
     visit(m->e0);
-    auto resolved_condition = state->get_expr_result<Z3Bitvector>()->get_val()->simplify();
+    auto resolved_condition = state->simplify(*state->get_expr_result<Z3Bitvector>()->get_val());
     // Short circuit here.
     if (resolved_condition.is_true()) {
         visit(m->e1);
@@ -72,6 +72,7 @@ class P4Scope {
     }
 
     bool has_type(cstring name) const { return type_map.count(name) > 0; }
+    const std::map<cstring, const IR::Type *> *get_type_map() const { return &type_map; }
 
     const IR::Type *resolve_type(const IR::Type *type) const {
         const IR::Type *ret_type = type;
@@ -0,0 +1,17 @@
+#include "simplify_cache.h"
+
+namespace P4::ToZ3 {
+
+z3::expr SimplifyCache::simplify(const z3::expr &expr) {
+    lookups++;
+    auto it = cache.find(expr.id());
+    if (it != cache.end()) {
+        hits++;
+        return it->second.second;
+    }
+    auto simplified = expr.simplify();
+    cache.emplace(expr.id(), std::pair{expr, simplified});
+    return simplified;
+}
+
+}  // namespace P4::ToZ3
@@ -0,0 +1,29 @@
+#ifndef TOZ3_COMMON_SIMPLIFY_CACHE_H_
+#define TOZ3_COMMON_SIMPLIFY_CACHE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+#include "../contrib/z3/z3++.h"
+
+namespace P4::ToZ3 {
+
+// Memoizes z3::expr::simplify() for all terms of one context. Terms are
+// hash-consed, so a term that is simplified again is found by its AST id.
+class SimplifyCache {
+ private:
+    // Keep the original term alive, so that its id is not reused.
+    std::unordered_map<unsigned, std::pair<z3::expr, z3::expr>> cache;
+    uint64_t hits = 0;
+    uint64_t lookups = 0;
+
+ public:
+    z3::expr simplify(const z3::expr &expr);
+    uint64_t get_hits() const { return hits; }
+    uint64_t get_lookups() const { return lookups; }
+};
+
+}  // namespace P4::ToZ3
+
+#endif  // TOZ3_COMMON_SIMPLIFY_CACHE_H_
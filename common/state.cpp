@@ -87,7 +87,7 @@ MemberStruct get_member_struct(P4State *state, Visitor *visitor, const IR::Expre
                       "Setting with an index of type %s not "
                       "implemented for stacks.",
                       index->get_static_type());
-            const auto expr = val_container->get_val()->simplify();
+            const auto expr = state->simplify(*val_container->get_val());
             if (is_first) {
                 member_struct.target_member = expr;
                 is_first = false;
@@ -756,6 +756,15 @@ ProgState P4State::clone_state() const {
     return cloned_state;
 }
 
+void P4State::import_static_scope(const P4State &other) {
+    for (const auto &decl : *other.main_scope.get_decl_map()) {
+        main_scope.declare_static_decl(decl.first, decl.second);
+    }
+    for (const auto &type : *other.main_scope.get_type_map()) {
+        main_scope.add_type(type.first, type.second);
+    }
+}
+
 VarMap P4State::clone_vars() const {
     VarMap cloned_vars;
     // this also implicitly shadows
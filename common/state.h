@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <memory>
 #include <ostream>
 #include <set>
 #include <typeinfo>
@@ -16,6 +17,7 @@
 #include "lib/cstring.h"
 #include "lib/exceptions.h"
 #include "scope.h"
+#include "simplify_cache.h"
 #include "toz3/common/type_base.h"
 #include "toz3/common/type_complex.h"
 #include "toz3/common/type_simple.h"
@@ -36,6 +38,14 @@ class P4State {
     bool is_exited = false;
     std::vector<std::pair<z3::expr, VarMap>> exit_states;
     z3::expr exit_cond = ctx->bool_val(true);
+    // Encode stack indices and table actions as bit vectors instead of integers.
+    bool bv_only = false;
+    // Pack the validity of all headers in a struct or stack into one bit vector.
+    bool packed_validity = false;
+    // Represent each header as a single bit vector with extract views for fields.
+    bool packed_headers = false;
+    // May be shared by all states of the same context.
+    std::shared_ptr<SimplifyCache> simplify_cache = std::make_shared<SimplifyCache>();
     P4Scope *get_mut_current_scope() { return &scopes.back(); }
     void set_var(Visitor *visitor, const IR::Expression *target, P4Z3Instance *rval);
     P4Declaration *find_static_decl(cstring name, P4Scope **owner_scope);
@@ -46,6 +56,17 @@ class P4State {
     const P4Scope &get_current_scope() const { return scopes.back(); }
     bool has_exited() const { return is_exited; }
     void set_exit(bool exit_state) { is_exited = exit_state; }
+    bool is_bv_only() const { return bv_only; }
+    void set_bv_only(bool bv_only_mode) { bv_only = bv_only_mode; }
+    bool is_packed_validity() const { return packed_validity; }
+    void set_packed_validity(bool packed_mode) { packed_validity = packed_mode; }
+    bool is_packed_headers() const { return packed_headers; }
+    void set_packed_headers(bool packed_mode) { packed_headers = packed_mode; }
+    void set_simplify_cache(std::shared_ptr<SimplifyCache> cache) {
+        simplify_cache = std::move(cache);
+    }
+    // Simplify through the cache of this context.
+    z3::expr simplify(const z3::expr &expr) const { return simplify_cache->simplify(expr); }
 
     explicit P4State(z3::context *context) : ctx(context) {
         // These two labels are part of the built in declarations.
@@ -112,6 +133,9 @@ class P4State {
     void merge_state(const z3::expr &cond, const ProgState &else_state);
     void restore_state(const ProgState &set_scopes) { scopes = set_scopes; }
     ProgState clone_state() const;
+    // Copy the types and static declarations of the global scope of another
+    // state. Variables are not copied, they are bound to their own state.
+    void import_static_scope(const P4State &other);
     VarMap get_vars() const;
     VarMap clone_vars() const;
     void restore_vars(const VarMap &input_map);
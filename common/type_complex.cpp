@@ -123,12 +123,18 @@ void StructBase::set_list(std::map<cstring, P4Z3Instance *> input_map) {
 void StructBase::merge(const z3::expr &cond, const P4Z3Instance &then_expr) {
     const auto *then_struct = then_expr.to<StructBase>();
     BUG_CHECK(then_struct, "Unsupported merge class.");
+    // A single ite covers the validity of every header below this instance.
+    if (can_merge_packed(*then_struct)) {
+        valid_bits = merge_ite(cond, *then_struct->valid_bits, *valid_bits);
+        merging_validity = true;
+    }
     for (auto member_tuple : members) {
         cstring member_name = member_tuple.first;
         auto *then_var = member_tuple.second;
         const auto *else_var = then_struct->get_const_member(member_name);
         then_var->merge(cond, *else_var);
     }
+    merging_validity = false;
 }
 
 P4Z3Instance *StructBase::cast_allocate(const IR::Type *dest_type) const {
@@ -147,6 +153,18 @@ void StructBase::propagate_validity(const z3::expr *valid_expr) {
     if (valid_expr != nullptr) {
         valid = *valid_expr;
     }
+    if (valid_bits.has_value()) {
+        auto *ctx = state->get_z3_ctx();
+        auto bits_width = valid_bits->get_sort().bv_size();
+        if (valid_expr == nullptr) {
+            valid_bits = ctx->bv_const(instance_name + "_valid_bits", bits_width);
+        } else {
+            auto all_valid = ~ctx->bv_val(0, bits_width);
+            valid_bits = z3::ite(*valid_expr, all_valid, ctx->bv_val(0, bits_width)).simplify();
+        }
+        propagate_nested_validity(valid_expr);
+        return;
+    }
     for (auto member_tuple : members) {
         auto *member = member_tuple.second;
         if (auto *z3_var = member->to_mut<StructBase>()) {
@@ -155,6 +173,195 @@ void StructBase::propagate_validity(const z3::expr *valid_expr) {
     }
 }
 
+void StructBase::propagate_nested_validity(const z3::expr *valid_expr) {
+    for (auto member_tuple : members) {
+        auto *member = member_tuple.second->to_mut<StructBase>();
+        if (member == nullptr || member->is<ListInstance>()) {
+            continue;
+        }
+        if (const auto *hdr = member->to<HeaderInstance>()) {
+            auto hdr_valid = hdr->get_valid();
+            member->propagate_nested_validity(&hdr_valid);
+            continue;
+        }
+        if (valid_expr != nullptr) {
+            member->valid = *valid_expr;
+        }
+        member->propagate_nested_validity(valid_expr);
+    }
+}
+
+void StructBase::collect_headers(std::vector<HeaderInstance *> *hdrs) {
+    if (auto *hdr = to_mut<HeaderInstance>()) {
+        hdrs->push_back(hdr);
+        return;
+    }
+    for (auto member_tuple : members) {
+        auto *member = member_tuple.second->to_mut<StructBase>();
+        if (member != nullptr && !member->is<ListInstance>()) {
+            member->collect_headers(hdrs);
+        }
+    }
+}
+
+void StructBase::collect_valid_indices(std::vector<uint64_t> *indices) const {
+    if (const auto *hdr = to<HeaderInstance>()) {
+        indices->push_back(hdr->valid_idx);
+        return;
+    }
+    for (auto member_tuple : members) {
+        const auto *member = member_tuple.second->to<StructBase>();
+        if (member != nullptr && !member->is<ListInstance>()) {
+            member->collect_valid_indices(indices);
+        }
+    }
+}
+
+void StructBase::clear_validity_owner() {
+    valid_bits.reset();
+    for (auto member_tuple : members) {
+        auto *member = member_tuple.second->to_mut<StructBase>();
+        if (member != nullptr && !member->is<ListInstance>()) {
+            member->clear_validity_owner();
+        }
+    }
+}
+
+void StructBase::pack_validity() {
+    if (!state->is_packed_validity()) {
+        return;
+    }
+    std::vector<HeaderInstance *> hdrs;
+    collect_headers(&hdrs);
+    if (hdrs.empty()) {
+        return;
+    }
+    auto *ctx = state->get_z3_ctx();
+    auto hdr_num = hdrs.size();
+    // If the headers already occupy a contiguous range of one owner, we can
+    // take a single slice. Otherwise, concatenate the bits of each header.
+    const auto *first_owner = hdrs[0]->valid_owner;
+    bool contiguous = first_owner != nullptr && first_owner->valid_bits.has_value();
+    for (size_t idx = 0; contiguous && idx < hdr_num; ++idx) {
+        contiguous = hdrs[idx]->valid_owner == first_owner &&
+                     hdrs[idx]->valid_idx == hdrs[0]->valid_idx + idx;
+    }
+    z3::expr bits(*ctx);
+    if (contiguous) {
+        const auto &owner_bits = *first_owner->valid_bits;
+        auto low = hdrs[0]->valid_idx;
+        bits = owner_bits.extract(low + hdr_num - 1, low);
+        if (owner_bits.is_numeral()) {
+            bits = bits.simplify();
+        }
+    } else {
+        z3::expr_vector hdr_bits(*ctx);
+        bool all_literal = true;
+        // The first header is the least significant bit.
+        for (auto it = hdrs.rbegin(); it != hdrs.rend(); ++it) {
+            auto hdr_valid = (*it)->get_valid();
+            all_literal = all_literal && (hdr_valid.is_true() || hdr_valid.is_false());
+            hdr_bits.push_back(z3::ite(hdr_valid, ctx->bv_val(1, 1), ctx->bv_val(0, 1)));
+        }
+        bits = z3::concat(hdr_bits);
+        if (all_literal) {
+            bits = bits.simplify();
+        }
+    }
+    clear_validity_owner();
+    valid_bits = bits;
+    for (size_t idx = 0; idx < hdr_num; ++idx) {
+        hdrs[idx]->valid_owner = this;
+        hdrs[idx]->valid_idx = idx;
+    }
+}
+
+void StructBase::adopt_validity(const StructBase &other) {
+    if (!state->is_packed_validity()) {
+        return;
+    }
+    if (!other.valid_bits.has_value()) {
+        pack_validity();
+        return;
+    }
+    // The copy has the same layout, so its headers take the slots of the
+    // original ones in the copied bits.
+    std::vector<HeaderInstance *> hdrs;
+    std::vector<uint64_t> indices;
+    collect_headers(&hdrs);
+    other.collect_valid_indices(&indices);
+    clear_validity_owner();
+    valid_bits = other.valid_bits;
+    for (size_t idx = 0; idx < hdrs.size(); ++idx) {
+        hdrs[idx]->valid_owner = this;
+        hdrs[idx]->valid_idx = indices[idx];
+    }
+}
+
+void StructBase::adopt_member_validity(P4Z3Instance *old_val, P4Z3Instance *new_val) {
+    if (!state->is_packed_validity()) {
+        return;
+    }
+    auto *old_struct = old_val->to_mut<StructBase>();
+    auto *new_struct = new_val->to_mut<StructBase>();
+    if (old_struct == nullptr || new_struct == nullptr) {
+        return;
+    }
+    std::vector<HeaderInstance *> old_hdrs;
+    std::vector<HeaderInstance *> new_hdrs;
+    old_struct->collect_headers(&old_hdrs);
+    new_struct->collect_headers(&new_hdrs);
+    if (new_hdrs.empty() || old_hdrs.size() != new_hdrs.size()) {
+        return;
+    }
+    std::vector<z3::expr> new_valids;
+    for (const auto *hdr : new_hdrs) {
+        new_valids.push_back(hdr->get_valid());
+    }
+    new_struct->clear_validity_owner();
+    for (size_t idx = 0; idx < new_hdrs.size(); ++idx) {
+        new_hdrs[idx]->valid_owner = old_hdrs[idx]->valid_owner;
+        new_hdrs[idx]->valid_idx = old_hdrs[idx]->valid_idx;
+        new_hdrs[idx]->store_valid(new_valids[idx]);
+    }
+}
+
+bool StructBase::can_merge_packed(const StructBase &other) const {
+    return valid_bits.has_value() && other.valid_bits.has_value() &&
+           valid_bits->get_sort().bv_size() == other.valid_bits->get_sort().bv_size();
+}
+
+z3::expr StructBase::get_valid_bit(uint64_t idx) const {
+    BUG_CHECK(valid_bits.has_value(), "%s does not own packed validity bits.", instance_name);
+    auto *ctx = state->get_z3_ctx();
+    auto bit_valid = valid_bits->extract(idx, idx) == ctx->bv_val(1, 1);
+    if (valid_bits->is_numeral()) {
+        return bit_valid.simplify();
+    }
+    return bit_valid;
+}
+
+void StructBase::set_valid_bit(uint64_t idx, const z3::expr &valid_val) {
+    BUG_CHECK(valid_bits.has_value(), "%s does not own packed validity bits.", instance_name);
+    auto *ctx = state->get_z3_ctx();
+    auto bits_width = valid_bits->get_sort().bv_size();
+    auto mask_str = Util::toString(big_int(1) << idx, 0, false);
+    auto mask = ctx->bv_val(mask_str.c_str(), bits_width);
+    bool fold = valid_bits->is_numeral();
+    if (valid_val.is_true()) {
+        valid_bits = *valid_bits | mask;
+    } else if (valid_val.is_false()) {
+        valid_bits = *valid_bits & ~mask;
+    } else {
+        fold = false;
+        auto bit_val = z3::ite(valid_val, mask, ctx->bv_val(0, bits_width));
+        valid_bits = (*valid_bits & ~mask) | bit_val;
+    }
+    if (fold) {
+        valid_bits = valid_bits->simplify();
+    }
+}
+
 void StructBase::bind(const z3::expr *bind_var, uint64_t offset) {
     auto var_width = get_width();
     // This struct is empty, we can not do anything here...
@@ -192,7 +399,10 @@ void StructBase::bind(const z3::expr *bind_var, uint64_t offset) {
 void StructBase::update_member(cstring name, P4Z3Instance *val) {
     // Assignments where we clearly know the header is invalid are invalid.
     // TODO: Handle the case with ambiguous ite valid.
-    if (!valid.simplify().is_false()) {
+    const auto *hdr = to<HeaderInstance>();
+    auto struct_valid = hdr != nullptr ? hdr->get_valid() : valid;
+    if (!struct_valid.simplify().is_false()) {
+        adopt_member_validity(members.at(name), val);
         members.at(name) = val;
     }
 }
@@ -243,21 +453,29 @@ StructInstance::StructInstance(P4State *state, const IR::Type_StructLike *type,
         insert_member(field->name.name, member_var);
         member_types.insert({field->name.name, resolved_type});
     }
+    pack_validity();
 }
 
-StructInstance *StructInstance::copy() const { return new StructInstance(*this); }
+StructInstance *StructInstance::copy() const {
+    auto *struct_copy = new StructInstance(*this);
+    struct_copy->adopt_validity(*this);
+    return struct_copy;
+}
 
 std::vector<std::pair<cstring, z3::expr>> StructInstance::get_z3_vars(
     cstring prefix, const z3::expr *valid_expr) const {
     // TODO: Clean this up and split it
     const z3::expr *tmp_valid = nullptr;
+    // In packed mode, this masks the fields with the bit of the header.
+    const auto *hdr = to<HeaderInstance>();
+    auto own_valid = hdr != nullptr ? hdr->get_valid() : valid;
     if (this->is<HeaderInstance>() && valid_expr == nullptr) {
-        valid_expr = &valid;
+        valid_expr = &own_valid;
         tmp_valid = valid_expr;
     } else if (valid_expr != nullptr) {
         tmp_valid = valid_expr;
     } else {
-        tmp_valid = &valid;
+        tmp_valid = &own_valid;
     }
     std::vector<std::pair<cstring, z3::expr>> z3_vars;
     for (auto member_tuple : members) {
@@ -278,12 +496,14 @@ std::vector<std::pair<cstring, z3::expr>> StructInstance::get_z3_vars(
             // We need to cast towards the member type
             const auto *dest_type = member_types.at(member_tuple.first);
             if (const auto *tb = dest_type->to<IR::Type_Bits>()) {
-                auto cast_val = z3::int2bv(tb->size, *z3_var->get_val()).simplify();
+                auto dest_sort = state->get_z3_ctx()->bv_sort(tb->size);
+                auto cast_val = pure_bv_cast(*z3_var->get_val(), dest_sort);
                 auto invalid_var = state->gen_z3_expr(cstring(INVALID_LABEL), dest_type);
                 auto valid_var = z3::ite(*tmp_valid, cast_val, invalid_var);
                 z3_vars.emplace_back(name, valid_var);
             } else if (const auto *tb = dest_type->to<IR::Type_Varbits>()) {
-                auto cast_val = z3::int2bv(tb->size, *z3_var->get_val()).simplify();
+                auto dest_sort = state->get_z3_ctx()->bv_sort(tb->size);
+                auto cast_val = pure_bv_cast(*z3_var->get_val(), dest_sort);
                 auto invalid_var = state->gen_z3_expr(cstring(INVALID_LABEL), dest_type);
                 auto valid_var = z3::ite(*tmp_valid, cast_val, invalid_var);
                 z3_vars.emplace_back(name, valid_var);
@@ -320,6 +540,8 @@ HeaderInstance::HeaderInstance(P4State *state, const IR::Type_Header *type, cstr
 
     // When we first instantiate a header, all its members need to be invalid.
     HeaderInstance::propagate_validity(&valid);
+    pack_validity();
+    pack_fields();
 
     add_function("setValid0"_cs, [this](Visitor *visitor, const IR::Vector<IR::Argument> *args) {
         setValid(visitor, args);
@@ -332,7 +554,12 @@ HeaderInstance::HeaderInstance(P4State *state, const IR::Type_Header *type, cstr
     });
 }
 
-HeaderInstance::HeaderInstance(const HeaderInstance &other) : StructInstance(other) {
+HeaderInstance::HeaderInstance(const HeaderInstance &other)
+    : StructInstance(other),
+      valid_owner(other.valid_owner),
+      valid_idx(other.valid_idx),
+      packed_val(other.packed_val),
+      field_slices(other.field_slices) {
     add_function("setValid0"_cs, [this](Visitor *visitor, const IR::Vector<IR::Argument> *args) {
         setValid(visitor, args);
     });
@@ -355,15 +582,21 @@ HeaderInstance &HeaderInstance::operator=(const HeaderInstance &other) {
 z3::expr HeaderInstance::operator==(const P4Z3Instance &other) const {
     auto is_eq = state->get_z3_ctx()->bool_val(true);
     if (const auto *other_hdr = other.to<HeaderInstance>()) {
-        auto other_is_valid = *other_hdr->get_valid();
-        for (auto member_tuple : members) {
-            auto member_name = member_tuple.first;
-            const auto *member_val = member_tuple.second;
-            const auto *other_val = other.get_member(member_name);
-            is_eq = is_eq && (member_val->operator==(*other_val));
+        auto is_valid = get_valid();
+        auto other_is_valid = other_hdr->get_valid();
+        if (packed_val.has_value() && other_hdr->packed_val.has_value() &&
+            width == other_hdr->width) {
+            is_eq = *packed_val == *other_hdr->packed_val;
+        } else {
+            for (auto member_tuple : members) {
+                auto member_name = member_tuple.first;
+                const auto *member_val = member_tuple.second;
+                const auto *other_val = other.get_member(member_name);
+                is_eq = is_eq && (member_val->operator==(*other_val));
+            }
         }
-        auto both_invalid = !(valid || other_is_valid);
-        auto both_valid_and_eq = (is_eq && valid && other_is_valid);
+        auto both_invalid = !(is_valid || other_is_valid);
+        auto both_valid_and_eq = (is_eq && is_valid && other_is_valid);
         return both_invalid || both_valid_and_eq;
     }
     P4C_UNIMPLEMENTED("Comparing a header to %s is not supported.", other.get_static_type());
@@ -371,69 +604,215 @@ z3::expr HeaderInstance::operator==(const P4Z3Instance &other) const {
 
 z3::expr HeaderInstance::operator!=(const P4Z3Instance &other) const { return !(*this == other); }
 
+void HeaderInstance::store_valid(const z3::expr &valid_val) {
+    if (valid_owner == nullptr) {
+        valid = valid_val;
+    } else {
+        valid_owner->set_valid_bit(valid_idx, valid_val);
+    }
+}
+
 void HeaderInstance::set_valid(const z3::expr &valid_val) {
-    valid = valid_val;
+    store_valid(valid_val);
     // If this is header is bound to a union we need to invalidate its peers
     if (parent_union != nullptr) {
         parent_union->update_validity(this, valid_val);
     }
 }
 
-const z3::expr *HeaderInstance::get_valid() const { return &valid; }
+z3::expr HeaderInstance::get_valid() const {
+    if (valid_owner == nullptr) {
+        return valid;
+    }
+    return valid_owner->get_valid_bit(valid_idx);
+}
 
 void HeaderInstance::setValid(Visitor * /*visitor*/, const IR::Vector<IR::Argument> * /*args*/) {
-    set_valid(state->get_z3_ctx()->bool_val(true));
-    propagate_validity(&valid);
+    auto valid_val = state->get_z3_ctx()->bool_val(true);
+    set_valid(valid_val);
+    propagate_validity(&valid_val);
     state->set_expr_result(new VoidResult());
 }
 
 void HeaderInstance::setInvalid(Visitor * /*visitor*/, const IR::Vector<IR::Argument> * /*args*/) {
-    set_valid(state->get_z3_ctx()->bool_val(false));
-    propagate_validity(&valid);
+    auto valid_val = state->get_z3_ctx()->bool_val(false);
+    set_valid(valid_val);
+    propagate_validity(&valid_val);
     set_undefined();
     state->set_expr_result(new VoidResult());
 }
 
 void HeaderInstance::isValid(Visitor * /*visitor*/, const IR::Vector<IR::Argument> * /*args*/) {
-    state->set_expr_result(new Z3Bitvector(state, &BOOL_TYPE, valid));
+    state->set_expr_result(new Z3Bitvector(state, &BOOL_TYPE, get_valid()));
 }
 
 void HeaderInstance::propagate_validity(const z3::expr *valid_expr) {
     if (valid_expr == nullptr) {
         cstring name = instance_name + "_valid";
         set_valid(state->get_z3_ctx()->bool_const(name));
-        valid_expr = &valid;
     } else {
         set_valid(*valid_expr);
     }
+    auto hdr_valid = get_valid();
     for (auto member_tuple : members) {
         auto *member = member_tuple.second;
         if (auto *z3_var = member->to_mut<StructBase>()) {
-            z3_var->propagate_validity(valid_expr);
+            z3_var->propagate_validity(&hdr_valid);
         }
     }
 }
 
-HeaderInstance *HeaderInstance::copy() const { return new HeaderInstance(*this); }
+HeaderInstance *HeaderInstance::copy() const {
+    auto *hdr_copy = new HeaderInstance(*this);
+    if (valid_owner != nullptr && valid_owner != this) {
+        // The bit belongs to an enclosing instance, which assigns the slot if
+        // it is copied too. Until then, the copy keeps its own validity.
+        hdr_copy->valid_owner = nullptr;
+        hdr_copy->valid = get_valid();
+        return hdr_copy;
+    }
+    hdr_copy->adopt_validity(*this);
+    return hdr_copy;
+}
 
 void HeaderInstance::merge(const z3::expr &cond, const P4Z3Instance &then_expr) {
     const auto *then_struct = then_expr.to<HeaderInstance>();
 
     BUG_CHECK(then_struct, "Unsupported merge class.");
-    auto valid_merge = z3::ite(cond, *then_struct->get_valid(), valid);
-    set_valid(valid_merge);
+    // Packed validity is merged once by the owner of the bits.
+    bool owner_merges = valid_owner != nullptr && valid_owner->is_merging_validity();
+    if (!owner_merges && !can_merge_packed(*then_struct)) {
+        auto valid_merge = merge_ite(cond, then_struct->get_valid(), get_valid());
+        set_valid(valid_merge);
+    }
+    if (packed_val.has_value() && then_struct->packed_val.has_value()) {
+        packed_val = merge_ite(cond, *then_struct->packed_val, *packed_val);
+        refresh_views();
+        return;
+    }
     StructBase::merge(cond, then_expr);
+    if (packed_val.has_value()) {
+        pack_fields();
+    }
+}
+
+void HeaderInstance::pack_fields() {
+    if (!state->is_packed_headers() || width == 0) {
+        return;
+    }
+    auto *ctx = state->get_z3_ctx();
+    z3::expr_vector field_vals(*ctx);
+    std::map<cstring, std::pair<uint64_t, uint64_t>> slices;
+    auto bit_idx = width;
+    for (auto member_tuple : members) {
+        const auto *field = member_tuple.second->to<Z3Bitvector>();
+        // Only flat headers are packed.
+        if (field == nullptr) {
+            packed_val.reset();
+            return;
+        }
+        auto field_val = *field->get_val();
+        if (field_val.is_bool()) {
+            field_val = z3::ite(field_val, ctx->bv_val(1, 1), ctx->bv_val(0, 1));
+        }
+        auto field_width = field_val.get_sort().bv_size();
+        if (field_width > bit_idx) {
+            packed_val.reset();
+            return;
+        }
+        slices.emplace(member_tuple.first, std::pair{bit_idx - 1, bit_idx - field_width});
+        field_vals.push_back(field_val);
+        bit_idx -= field_width;
+    }
+    packed_val = z3::concat(field_vals);
+    field_slices = slices;
+}
+
+void HeaderInstance::refresh_views() {
+    auto *ctx = state->get_z3_ctx();
+    for (auto &member_tuple : members) {
+        const auto *field_type = member_types.at(member_tuple.first);
+        auto slice = field_slices.at(member_tuple.first);
+        auto field_val = packed_val->extract(slice.first, slice.second);
+        bool is_signed = false;
+        if (field_type->is<IR::Type_Boolean>()) {
+            field_val = field_val == ctx->bv_val(1, 1);
+        } else if (const auto *tb = field_type->to<IR::Type_Bits>()) {
+            is_signed = tb->isSigned;
+        }
+        member_tuple.second = new Z3Bitvector(state, field_type, field_val, is_signed);
+    }
+}
+
+void HeaderInstance::update_member(cstring name, P4Z3Instance *val) {
+    const auto *field = val->to<Z3Bitvector>();
+    if (!packed_val.has_value() || field == nullptr) {
+        packed_val.reset();
+        StructBase::update_member(name, val);
+        return;
+    }
+    // Assignments where we clearly know the header is invalid are invalid.
+    if (get_valid().simplify().is_false()) {
+        return;
+    }
+    auto *ctx = state->get_z3_ctx();
+    auto field_val = *field->get_val();
+    if (field_val.is_bool()) {
+        field_val = z3::ite(field_val, ctx->bv_val(1, 1), ctx->bv_val(0, 1));
+    }
+    // Write the field as a slice update of the packed vector.
+    auto slice = field_slices.at(name);
+    if (field_val.get_sort().bv_size() != slice.first - slice.second + 1) {
+        packed_val.reset();
+        StructBase::update_member(name, val);
+        return;
+    }
+    z3::expr_vector parts(*ctx);
+    if (slice.first + 1 < width) {
+        parts.push_back(packed_val->extract(width - 1, slice.first + 1));
+    }
+    parts.push_back(field_val);
+    if (slice.second > 0) {
+        parts.push_back(packed_val->extract(slice.second - 1, 0));
+    }
+    packed_val = z3::concat(parts);
+    members.at(name) = val;
+}
+
+void HeaderInstance::set_undefined() {
+    if (!packed_val.has_value()) {
+        StructBase::set_undefined();
+        return;
+    }
+    auto *ctx = state->get_z3_ctx();
+    packed_val = ctx->constant(UNDEF_LABEL, ctx->bv_sort(width));
+    refresh_views();
+}
+
+void HeaderInstance::bind(const z3::expr *bind_var, uint64_t offset) {
+    if (!packed_val.has_value()) {
+        StructBase::bind(bind_var, offset);
+        return;
+    }
+    if (bind_var == nullptr) {
+        packed_val = state->get_z3_ctx()->bv_const(instance_name, width);
+    } else {
+        packed_val = bind_var->extract(offset - 1, offset - width);
+    }
+    refresh_views();
 }
 
 void HeaderInstance::set_list(std::vector<P4Z3Instance *> input_list) {
-    set_valid(state->get_z3_ctx()->bool_val(true));
-    propagate_validity(&valid);
+    auto valid_val = state->get_z3_ctx()->bool_val(true);
+    set_valid(valid_val);
+    propagate_validity(&valid_val);
     StructBase::set_list(input_list);
 }
 
 void HeaderInstance::set_list(std::map<cstring, P4Z3Instance *> input_map) {
-    set_valid(state->get_z3_ctx()->bool_val(true));
-    propagate_validity(&valid);
+    auto valid_val = state->get_z3_ctx()->bool_val(true);
+    set_valid(valid_val);
+    propagate_validity(&valid_val);
     StructBase::set_list(input_map);
 }
 
@@ -450,11 +829,11 @@ StackInstance
 StackInstance::StackInstance(P4State *state, const IR::Type_Stack *type, cstring name,
                              uint64_t member_id)
     : IndexableInstance(state, type, name, member_id),
-      nextIndex(Z3Int(state, 0)),
-      lastIndex(Z3Int(state, 0)),
-      size(Z3Int(state, type->getSize())),
       int_size(type->getSize()),
       elem_type(state->resolve_type(type->elementType)) {
+    nextIndex = make_index(state->get_z3_ctx()->int_val(0));
+    lastIndex = nextIndex;
+    size = make_index(state->get_z3_ctx()->int_val(static_cast<uint64_t>(int_size)));
     auto flat_id = member_id;
     for (size_t idx = 0; idx < int_size; ++idx) {
         auto *member_var = state->gen_instance(name, elem_type, flat_id);
@@ -468,6 +847,7 @@ StackInstance::StackInstance(P4State *state, const IR::Type_Stack *type, cstring
         insert_member(member_name, member_var);
         member_types.insert({member_name, elem_type});
     }
+    pack_validity();
     add_function("push_front1"_cs, [this](Visitor *visitor, const IR::Vector<IR::Argument> *args) {
         push_front(visitor, args);
     });
@@ -476,7 +856,23 @@ StackInstance::StackInstance(P4State *state, const IR::Type_Stack *type, cstring
     });
 }
 
-StackInstance *StackInstance::copy() const { return new StackInstance(*this); }
+StackInstance *StackInstance::copy() const {
+    auto *stack_copy = new StackInstance(*this);
+    stack_copy->adopt_validity(*this);
+    return stack_copy;
+}
+
+NumericVal *StackInstance::make_index(const z3::expr &index) const {
+    if (state->is_bv_only()) {
+        auto bv_sort = state->get_z3_ctx()->bv_sort(P4_STD_BIT_TYPE.size);
+        return new Z3Bitvector(state, &P4_STD_BIT_TYPE,
+                               state->simplify(pure_bv_cast(index, bv_sort)));
+    }
+    if (index.is_bv()) {
+        return new Z3Int(state, state->simplify(z3::bv2int(index, false)));
+    }
+    return new Z3Int(state, state->simplify(index));
+}
 
 StackInstance::StackInstance(const StackInstance &other)
     : IndexableInstance(other),
@@ -503,22 +899,22 @@ StackInstance &StackInstance::operator=(const StackInstance &other) {
 
 P4Z3Instance *StackInstance::get_member(cstring name) const {
     if (name == "size") {
-        return &size;
+        return size;
     }
     if (name == "nextIndex") {
-        return &nextIndex;
+        return nextIndex;
     }
     if (name == "lastIndex") {
-        return &lastIndex;
+        return lastIndex;
     }
     if (name == "next") {
         // TODO: Move this into extract as functionality
         lastIndex = nextIndex;
         // nextIndex = Z3Int(state, *nextIndex.get_val() + 1);
-        return get_member(*lastIndex.get_val());
+        return get_member(*lastIndex->get_val());
     }
     if (name == "last") {
-        return get_member(*lastIndex.get_val());
+        return get_member(*lastIndex->get_val());
     }
     return StructBase::get_member(name);
 }
@@ -539,16 +935,17 @@ void StackInstance::update_member(cstring name, P4Z3Instance *val) {
         return;
     }
     if (name == "next") {
-        name = nextIndex.get_val()->to_string();
+        name = state->simplify(*nextIndex->get_val()).get_decimal_string(0);
     }
     if (name == "last") {
-        name = lastIndex.get_val()->to_string();
+        name = state->simplify(*lastIndex->get_val()).get_decimal_string(0);
     }
+    adopt_member_validity(members.at(name), val);
     members.at(name) = val;
 }
 
 P4Z3Instance *StackInstance::get_member(const z3::expr &index) const {
-    auto val = index.simplify();
+    auto val = state->simplify(index);
     std::string val_str;
     if (val.is_numeral(val_str, 0)) {
         return StructBase::get_member(val_str);
@@ -577,7 +974,7 @@ void StackInstance::push_front(Visitor *visitor, const IR::Vector<IR::Argument>
     }
     visitor->visit(args->at(0)->expression);
     const auto *numeric_val = state->get_expr_result<NumericVal>();
-    const auto z3_push_size = numeric_val->get_val()->simplify();
+    const auto z3_push_size = state->simplify(*numeric_val->get_val());
     auto int_push_size = z3_push_size.get_numeral_uint64();
     // TODO: Checks
     for (size_t idx = 0; idx < int_push_size; ++idx) {
@@ -589,8 +986,9 @@ void StackInstance::push_front(Visitor *visitor, const IR::Vector<IR::Argument>
         auto *hdr = member->to_mut<HeaderInstance>();
         hdr->setInvalid(visitor, {});
     }
-    nextIndex = Z3Int(state, (*nextIndex.get_val() + z3_push_size).simplify());
-    if ((nextIndex > size).is_true()) {
+    const auto *push_size = make_index(z3_push_size);
+    nextIndex = make_index(*nextIndex->get_val() + *push_size->get_val());
+    if ((*nextIndex > *size).is_true()) {
         nextIndex = size;
     }
     lastIndex = nextIndex;
@@ -601,7 +999,7 @@ void StackInstance::pop_front(Visitor *visitor, const IR::Vector<IR::Argument> *
     }
     visitor->visit(args->at(0)->expression);
     const auto *numeric_val = state->get_expr_result<NumericVal>();
-    const auto z3_pop_size = numeric_val->get_val()->simplify();
+    const auto z3_pop_size = state->simplify(*numeric_val->get_val());
     auto int_pop_size = z3_pop_size.get_numeral_uint64();
     auto last_range = int_pop_size > int_size ? 0 : int_size - int_pop_size;
     for (size_t idx = last_range; idx < int_size; ++idx) {
@@ -613,10 +1011,11 @@ void StackInstance::pop_front(Visitor *visitor, const IR::Vector<IR::Argument> *
         auto *hdr = member->to_mut<HeaderInstance>();
         hdr->setInvalid(visitor, {});
     }
-    if ((*nextIndex.get_val() < z3_pop_size).is_true()) {
-        nextIndex = Z3Int(state, state->get_z3_ctx()->int_val(0));
+    const auto *pop_size = make_index(z3_pop_size);
+    if ((*nextIndex < *pop_size).is_true()) {
+        nextIndex = make_index(state->get_z3_ctx()->int_val(0));
     } else {
-        nextIndex = Z3Int(state, (*nextIndex.get_val() - z3_pop_size).simplify());
+        nextIndex = make_index(*nextIndex->get_val() - *pop_size->get_val());
     }
     lastIndex = nextIndex;
 }
@@ -669,6 +1068,7 @@ HeaderUnionInstance::HeaderUnionInstance(P4State *state, const IR::Type_HeaderUn
             P4C_UNIMPLEMENTED("Type \"%s\" not supported!", field->type);
         }
     }
+    pack_validity();
     add_function("isValid0"_cs, [this](Visitor *visitor, const IR::Vector<IR::Argument> *args) {
         isValid(visitor, args);
     });
@@ -719,7 +1119,7 @@ z3::expr HeaderUnionInstance::get_valid() const {
     for (const auto &member : members) {
         const auto *hi = member.second->to<HeaderInstance>();
         BUG_CHECK(hi, "Unexpected instance %s", member.second->to_string());
-        valid_var = valid_var || *hi->get_valid();
+        valid_var = valid_var || hi->get_valid();
     }
     return valid_var;
 }
@@ -729,18 +1129,22 @@ void HeaderUnionInstance::isValid(Visitor * /*visitor*/,
     state->set_expr_result(new Z3Bitvector(state, &BOOL_TYPE, get_valid()));
 }
 
-HeaderUnionInstance *HeaderUnionInstance::copy() const { return new HeaderUnionInstance(*this); }
+HeaderUnionInstance *HeaderUnionInstance::copy() const {
+    auto *union_copy = new HeaderUnionInstance(*this);
+    union_copy->adopt_validity(*this);
+    return union_copy;
+}
 
 void HeaderUnionInstance::update_validity(const HeaderInstance * /*child*/,
                                           const z3::expr &valid_val) {
     for (auto &member : members) {
         auto *hi = member.second->to_mut<HeaderInstance>();
         BUG_CHECK(hi, "Unexpected instance %s", member.second->to_string());
-        const auto *old_valid = hi->get_valid();
+        auto old_valid = hi->get_valid();
         // This is kind of stupid but works,
         // I have no means to check child equality yet
         // TODO: Test this...
-        hi->valid = z3::ite(valid_val, state->get_z3_ctx()->bool_val(false), *old_valid);
+        hi->store_valid(z3::ite(valid_val, state->get_z3_ctx()->bool_val(false), old_valid));
     }
 }
 
@@ -816,7 +1220,7 @@ void EnumBase::set_enum_val(const z3::expr &enum_input) { val = enum_input; }
 void EnumBase::merge(const z3::expr &cond, const P4Z3Instance &then_expr) {
     const auto *then_enum = then_expr.to<EnumBase>();
     BUG_CHECK(then_enum, "Unsupported merge class.");
-    val = z3::ite(cond, *then_enum->get_val(), val);
+    val = merge_ite(cond, *then_enum->get_val(), val);
 }
 
 EnumBase::EnumBase(const EnumBase &other)
@@ -1123,9 +1527,14 @@ TupleInstance::TupleInstance(P4State *state, const IR::Type_Tuple *type, cstring
         member_types.insert({name, resolved_type});
         idx++;
     }
+    pack_validity();
 }
 
-TupleInstance *TupleInstance::copy() const { return new TupleInstance(*this); }
+TupleInstance *TupleInstance::copy() const {
+    auto *tuple_copy = new TupleInstance(*this);
+    tuple_copy->adopt_validity(*this);
+    return tuple_copy;
+}
 
 P4Z3Instance *TupleInstance::get_member(const z3::expr &index) const {
     auto val = index.simplify();
@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <list>
 #include <map>      // std::map
+#include <optional>
 #include <string>   // std::to_string
 #include <utility>  // std::pair
 #include <vector>   // std::vector
@@ -45,6 +46,23 @@ class StructBase : public P4Z3Instance {
     uint64_t width;
     z3::expr valid;
     cstring instance_name;
+    // In packed validity mode, the validity of all headers below the instance
+    // that owns the layout, one bit per header in declaration order.
+    std::optional<z3::expr> valid_bits;
+    // Set while the owner merges valid_bits, the headers then skip their own merge.
+    bool merging_validity = false;
+
+    void collect_headers(std::vector<HeaderInstance *> *hdrs);
+    // The slots of the headers below this instance in their validity owners.
+    void collect_valid_indices(std::vector<uint64_t> *indices) const;
+    // Take ownership of the validity of all headers below this instance.
+    void pack_validity();
+    void adopt_validity(const StructBase &other);
+    void clear_validity_owner();
+    bool can_merge_packed(const StructBase &other) const;
+    void propagate_nested_validity(const z3::expr *valid_expr);
+    // Move the headers of a new member value into the slots of the old one.
+    void adopt_member_validity(P4Z3Instance *old_val, P4Z3Instance *new_val);
 
  public:
     StructBase(P4State *state, const IR::Type *type, cstring name, uint64_t member_id);
@@ -77,6 +95,9 @@ class StructBase : public P4Z3Instance {
     void insert_member(cstring name, P4Z3Instance *val) { members.emplace(name, val); }
     const ordered_map<cstring, P4Z3Instance *> *get_member_map() const { return &members; }
     void set_undefined() override;
+    z3::expr get_valid_bit(uint64_t idx) const;
+    void set_valid_bit(uint64_t idx, const z3::expr &valid_val);
+    bool is_merging_validity() const { return merging_validity; }
     virtual void propagate_validity(const z3::expr *valid_expr);
     virtual void bind(const z3::expr *bind_var, uint64_t offset);
     virtual void set_list(std::vector<P4Z3Instance *>);
@@ -126,14 +147,26 @@ class HeaderInstance : public StructInstance, public FunctionClass {
     // HeaderUnionInstances are friend classes because they need direct var
     // access outside the API
     friend HeaderUnionInstance;
+    // StructBase assigns the packed validity slots.
+    friend StructBase;
 
  private:
     HeaderUnionInstance *parent_union = nullptr;
+    // The owner of the packed validity bit of this header, if any.
+    StructBase *valid_owner = nullptr;
+    uint64_t valid_idx = 0;
+    // With packed headers, all fields as one bit vector, first field in the
+    // most significant bits. The members are extract views of this vector.
+    std::optional<z3::expr> packed_val;
+    std::map<cstring, std::pair<uint64_t, uint64_t>> field_slices;
+    void store_valid(const z3::expr &valid_val);
+    void pack_fields();
+    void refresh_views();
 
  public:
     HeaderInstance(P4State *state, const IR::Type_Header *type, cstring name, uint64_t member_id);
     void set_valid(const z3::expr &valid_val);
-    const z3::expr *get_valid() const;
+    z3::expr get_valid() const;
     void setValid(Visitor *visitor, const IR::Vector<IR::Argument> *args);
     void setInvalid(Visitor *visitor, const IR::Vector<IR::Argument> *args);
     void isValid(Visitor *visitor, const IR::Vector<IR::Argument> *args);
@@ -141,12 +174,15 @@ class HeaderInstance : public StructInstance, public FunctionClass {
     void merge(const z3::expr &cond, const P4Z3Instance &then_expr) override;
     void set_list(std::vector<P4Z3Instance *> input_list) override;
     void set_list(std::map<cstring, P4Z3Instance *> input_map) override;
+    void update_member(cstring name, P4Z3Instance *val) override;
+    void set_undefined() override;
+    void bind(const z3::expr *bind_var, uint64_t offset) override;
     void bind_to_union(HeaderUnionInstance *union_parent);
 
     cstring get_static_type() const override { return "HeaderInstance"_cs; }
     cstring to_string() const override {
         std::string ret = "HeaderInstance(";
-        ret += "valid: " + valid.to_string() + ", ";
+        ret += "valid: " + get_valid().to_string() + ", ";
         bool first = true;
         for (auto tuple : members) {
             if (!first) {
@@ -177,11 +213,13 @@ class IndexableInstance : public StructBase {
 
 class StackInstance : public IndexableInstance, public FunctionClass {
  private:
-    mutable Z3Int nextIndex;
-    mutable Z3Int lastIndex;
-    mutable Z3Int size;
+    // Integers by default, bit<32> in bit-vector only mode.
+    mutable NumericVal *nextIndex;
+    mutable NumericVal *lastIndex;
+    NumericVal *size;
     size_t int_size;
     const IR::Type *elem_type;
+    NumericVal *make_index(const z3::expr &index) const;
 
  public:
     explicit StackInstance(P4State *state, const IR::Type_Stack *type, cstring name,
@@ -497,6 +535,9 @@ class P4TableInstance : public P4Declaration, public FunctionClass {
     z3::expr produce_const_match(Visitor *visitor,
                                  std::vector<const P4Z3Instance *> *evaluated_keys,
                                  const IR::ListExpression *entry_keys) const;
+    // The symbolic choice of action and the value that selects action idx.
+    z3::expr get_action_selector() const;
+    z3::expr get_action_index(uint64_t idx) const;
 };
 
 class ExternInstance : public P4Z3Instance, public FunctionClass {
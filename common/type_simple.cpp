@@ -22,6 +22,12 @@ z3::expr pure_bv_cast(const z3::expr &expr, const z3::sort &dest_type) {
     if (expr.is_bv()) {
         expr_size = expr.get_sort().bv_size();
     } else if (expr.is_int()) {
+        // Integer literals become bit-vector literals right away, so casts do
+        // not put integer terms into the encoding.
+        auto int_val = expr.simplify();
+        if (int_val.is_numeral()) {
+            return expr.ctx().bv_val(int_val.get_decimal_string(0).c_str(), dest_type.bv_size());
+        }
         return z3::int2bv(dest_type.bv_size(), expr).simplify();
     } else if (expr.is_bool()) {
         auto *ctx = &expr.get_sort().ctx();
@@ -45,6 +51,41 @@ z3::expr pure_bv_cast(const z3::expr &expr, const z3::sort &dest_type) {
     return cast_expr;
 }
 
+z3::expr merge_ite(const z3::expr &cond, const z3::expr &then_val, const z3::expr &else_val) {
+    if (cond.is_true()) {
+        return then_val;
+    }
+    if (cond.is_false()) {
+        return else_val;
+    }
+    // ite(not c, a, b) is ite(c, b, a).
+    if (cond.is_app() && cond.decl().decl_kind() == Z3_OP_NOT) {
+        return merge_ite(cond.arg(0), else_val, then_val);
+    }
+    // A nested ite guarded by the same condition can only take one branch.
+    auto then_term = then_val;
+    if (then_term.is_ite() && z3::eq(then_term.arg(0), cond)) {
+        then_term = then_term.arg(1);
+    }
+    auto else_term = else_val;
+    if (else_term.is_ite() && z3::eq(else_term.arg(0), cond)) {
+        else_term = else_term.arg(2);
+    }
+    if (z3::eq(then_term, else_term)) {
+        return then_term;
+    }
+    if (then_term.is_bool()) {
+        if (then_term.is_true() && else_term.is_false()) {
+            return cond;
+        }
+        if (then_term.is_false() && else_term.is_true()) {
+            return !cond;
+        }
+    }
+    // Terms are hash-consed, identical ites are shared by the context.
+    return z3::ite(cond, then_term, else_term);
+}
+
 z3::expr align_bitvectors(const P4Z3Instance *target, const z3::sort &bv_cast,
                           bool align_bv = false, cstring op = ""_cs) {
     const z3::expr *cast_expr = nullptr;
@@ -364,22 +405,10 @@ Z3Bitvector *Z3Bitvector::copy() const { return new Z3Bitvector(state, p4_type,
 
 void Z3Bitvector::merge(const z3::expr &cond, const P4Z3Instance &then_expr) {
     if (const auto *then_expr_var = then_expr.to<Z3Bitvector>()) {
-        if (cond.is_false()) {
-            val = val;
-        } else if (cond.is_true()) {
-            val = then_expr_var->val;
-        } else {
-            val = z3::ite(cond, then_expr_var->val, val);
-        }
+        val = merge_ite(cond, then_expr_var->val, val);
     } else if (const auto *then_expr_var = then_expr.to<Z3Int>()) {
         z3::expr cast_val = pure_bv_cast(*then_expr_var->get_val(), val.get_sort());
-        if (cond.is_false()) {
-            val = val;
-        } else if (cond.is_true()) {
-            val = cast_val;
-        } else {
-            val = z3::ite(cond, cast_val, val);
-        }
+        val = merge_ite(cond, cast_val, val);
     } else {
         P4C_UNIMPLEMENTED("Z3Bitvector: Merge with %s of type %s not supported.",
                           then_expr.to_string(), then_expr.get_static_type());
@@ -407,10 +436,10 @@ Z3Int *Z3Int::copy() const { return new Z3Int(state, val); }
 
 void Z3Int::merge(const z3::expr &cond, const P4Z3Instance &then_expr) {
     if (const auto *then_expr_var = then_expr.to<Z3Int>()) {
-        val = z3::ite(cond, then_expr_var->val, val);
+        val = merge_ite(cond, then_expr_var->val, val);
     } else if (const auto *then_expr_var = then_expr.to<Z3Bitvector>()) {
         auto cast_val = pure_bv_cast(val, then_expr_var->get_val()->get_sort());
-        val = z3::ite(cond, *then_expr_var->get_val(), cast_val);
+        val = merge_ite(cond, *then_expr_var->get_val(), cast_val);
     } else {
         BUG("Unsupported merge class: %s", &then_expr);
     }
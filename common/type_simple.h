@@ -17,6 +17,8 @@ namespace P4::ToZ3 {
 class P4State;
 
 z3::expr pure_bv_cast(const z3::expr &expr, const z3::sort &dest_type);
+// Build ite(cond, then_val, else_val) for merges, folding trivial cases.
+z3::expr merge_ite(const z3::expr &cond, const z3::expr &then_val, const z3::expr &else_val);
 
 class VoidResult : public P4Z3Instance {
  public:
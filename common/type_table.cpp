@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
@@ -135,7 +136,7 @@ z3::expr compute_table_hit(Visitor *visitor, P4State *state, cstring table_name,
                   "supported for tables.",
                   key_eval->get_static_type());
         cstring key_name = table_name + "_table_key_" + std::to_string(idx);
-        const auto key_eval_z3 = val_container->get_val()->simplify();
+        const auto key_eval_z3 = state->simplify(*val_container->get_val());
         const auto key_z3_sort = key_eval_z3.get_sort();
         const auto key_match = ctx->constant(key_name, key_z3_sort);
         // It is actually possible to use a variety of types as key.
@@ -242,8 +243,28 @@ z3::expr P4TableInstance::produce_const_match(Visitor *visitor,
     }
     return match;
 }
-void P4TableInstance::apply(Visitor *visitor, const IR::Vector<IR::Argument> *args) {
+// In bit-vector only mode, the action selector has the same width in every
+// pass, no matter how many actions a table has.
+constexpr unsigned ACTION_IDX_WIDTH = 32;
+
+z3::expr P4TableInstance::get_action_selector() const {
+    auto *ctx = state->get_z3_ctx();
+    auto table_action_name = table_props.table_name + "action_idx";
+    if (state->is_bv_only()) {
+        return ctx->bv_const(table_action_name.c_str(), ACTION_IDX_WIDTH);
+    }
+    return ctx->int_const(table_action_name.c_str());
+}
+
+z3::expr P4TableInstance::get_action_index(uint64_t idx) const {
     auto *ctx = state->get_z3_ctx();
+    if (state->is_bv_only()) {
+        return ctx->bv_val(idx, ACTION_IDX_WIDTH);
+    }
+    return ctx->int_val(idx);
+}
+
+void P4TableInstance::apply(Visitor *visitor, const IR::Vector<IR::Argument> *args) {
     const auto *table_decl = get_decl()->checkedTo<IR::P4Table>();
     const auto *params = table_decl->getApplyParameters();
     const auto *type_params = table_decl->getApplyMethodType()->getTypeParameters();
@@ -251,9 +272,8 @@ void P4TableInstance::apply(Visitor *visitor, const IR::Vector<IR::Argument> *ar
     state->copy_in(visitor, param_info);
 
     std::vector<const P4Z3Instance *> evaluated_keys;
-    z3::expr new_hit =
-        compute_table_hit(visitor, state, table_props.table_name, table_props.keys, &evaluated_keys)
-            .simplify();
+    z3::expr new_hit = state->simplify(compute_table_hit(visitor, state, table_props.table_name,
+                                                         table_props.keys, &evaluated_keys));
 
     std::vector<std::pair<z3::expr, VarMap>> action_vars;
     bool has_exited = true;
@@ -285,10 +305,9 @@ void P4TableInstance::apply(Visitor *visitor, const IR::Vector<IR::Argument> *ar
         }
         // Then the actions
         if (!table_props.immutable) {
-            auto table_action_name = table_props.table_name + "action_idx";
-            auto table_action = ctx->int_const(table_action_name.c_str());
+            auto table_action = get_action_selector();
             for (const auto *action : table_props.actions) {
-                auto cond = new_hit && (table_action == state->get_z3_ctx()->int_val(idx));
+                auto cond = new_hit && (table_action == get_action_index(idx));
                 auto old_vars = state->clone_vars();
                 state->push_forward_cond(cond);
                 auto action_label = table_props.table_name + std::to_string(idx);
@@ -21,6 +21,8 @@
 #define EXIT_VIOLATION 20
 // Comparing two programs, they have undefined behavior that makes them unequal
 #define EXIT_UNDEF 30
+// Comparing two programs, the solver gave up on at least one pair of passes
+#define EXIT_UNKNOWN 40
 
 #define UNDEF_LABEL "undefined"
 #define INVALID_LABEL "invalid"
@@ -47,6 +49,10 @@ class Logger {
         cstring reg_str = cstring(__FILE__) + ":" + std::to_string(LOG_LEVEL);
         Log::addDebugSpec(reg_str.c_str());
     }
+    // Whether messages of this level are printed, to skip work done only for them.
+    static bool is_enabled(size_t level) {
+        return level <= LOG_LEVEL && LOGGING(static_cast<int>(level));
+    }
     template <typename... Args>
     static void log_msg(size_t level, const std::string &msg, Args &...args) {
         if (level > LOG_LEVEL) {
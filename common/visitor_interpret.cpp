@@ -328,7 +328,7 @@ void DoBitFolding::postorder(IR::Type_Bits *tb) {
     if (tb->expression != nullptr) {
         tb->expression->apply(Z3Visitor(state, false));
         const auto *result = state->get_expr_result<NumericVal>();
-        auto int_size = result->get_val()->simplify().get_numeral_uint64();
+        auto int_size = state->simplify(*result->get_val()).get_numeral_uint64();
         tb->size = int_size;
         tb->expression = nullptr;
     }
@@ -338,7 +338,7 @@ void DoBitFolding::postorder(IR::Type_Varbits *tb) {
     if (tb->expression != nullptr) {
         tb->expression->apply(Z3Visitor(state, false));
         const auto *result = state->get_expr_result<NumericVal>();
-        auto int_size = result->get_val()->simplify().get_numeral_uint64();
+        auto int_size = state->simplify(*result->get_val()).get_numeral_uint64();
         tb->size = int_size;
         tb->expression = nullptr;
     }
@@ -517,8 +517,7 @@ SwitchCasePairs handle_table_switch(Z3Visitor *visitor, const P4TableInstance *t
     z3::expr fall_through = ctx->bool_val(false);
     z3::expr matches = ctx->bool_val(false);
     bool has_default = false;
-    auto table_action_name = table->table_props.table_name + "action_idx";
-    auto action_taken = ctx->int_const(table_action_name.c_str());
+    auto action_taken = table->get_action_selector();
     std::map<cstring, int> action_mapping;
     size_t idx = 0;
     for (const auto *action : table->table_props.actions) {
@@ -531,7 +530,7 @@ SwitchCasePairs handle_table_switch(Z3Visitor *visitor, const P4TableInstance *t
     for (const auto *switch_case : cases) {
         if (const auto *label = switch_case->label->to<IR::PathExpression>()) {
             auto mapped_idx = action_mapping[label->path->name.name];
-            auto cond = action_taken == mapped_idx;
+            auto cond = action_taken == table->get_action_index(mapped_idx);
             // There is no block for the switch.
             // This expressions falls through to the next switch case.
             fall_through = fall_through || cond;
@@ -653,7 +652,7 @@ IfStatement
 
 bool Z3Visitor::preorder(const IR::IfStatement *ifs) {
     visit(ifs->condition);
-    auto z3_cond = state->get_expr_result<Z3Bitvector>()->get_val()->simplify();
+    auto z3_cond = state->simplify(*state->get_expr_result<Z3Bitvector>()->get_val());
     if (z3_cond.is_true()) {
         visit(ifs->ifTrue);
         return false;
@@ -1,18 +1,30 @@
 #include "compare.h"
 
+#include <algorithm>
 #include <array>
 #include <cstdlib>
+#include <filesystem>
 #include <iomanip>
 #include <iostream>
 #include <list>
+#include <memory>
+#include <optional>
 #include <set>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include "frontends/common/parseInput.h"
 #include "ir/ir.h"
 #include "lib/error.h"
 #include "lib/exceptions.h"
+#include "simulate.h"
+#include "solver.h"
+#include "toz3/common/block_memo.h"
 #include "toz3/common/create_z3.h"
+#include "toz3/common/simplify_cache.h"
 #include "toz3/common/state.h"
 #include "toz3/common/type_base.h"
 #include "toz3/common/util.h"
@@ -25,19 +37,126 @@ namespace P4::ToZ3 {
 // Passes that are not supported for translation validation.
 static const std::array<cstring, 1> SKIPPED_PASSES = {"FlattenHeaderUnion"_cs};
 
+// The interpreter state after the declarations of the system include files,
+// such as core.p4 and v1model.p4. Every pass includes the same files, so their
+// types and static declarations are interpreted once and then imported into
+// the state of each pass.
+class PreludeSnapshot {
+ private:
+    std::optional<P4State> state;
+    // Identifies the prelude and the encoding the snapshot was built with.
+    std::vector<std::string> key;
+
+ public:
+    // Returns the snapshot of the prelude, building it if the prelude or the
+    // encoding has changed. Returns nullptr if the prelude can not be
+    // snapshotted.
+    const P4State *get(z3::context *ctx, const IR::Vector<IR::Node> &prelude,
+                       const CompareConfig &config);
+};
+
+// Whether the declaration stems from a system include file such as core.p4.
+bool is_prelude_decl(const IR::Node *node) {
+    return node->srcInfo.isValid() && isSystemFile(node->srcInfo.getSourceFile());
+}
+
+// Enums and errors bind variables in the global scope. These are owned by the
+// state that declares them, so they are not part of the snapshot.
+bool binds_prelude_var(const IR::Node *node) {
+    return node->is<IR::Type_Enum>() || node->is<IR::Type_Error>() ||
+           node->is<IR::Type_SerEnum>();
+}
+
+const P4State *PreludeSnapshot::get(z3::context *ctx, const IR::Vector<IR::Node> &prelude,
+                                    const CompareConfig &config) {
+    // Types are encoded differently depending on these flags.
+    std::vector<std::string> prelude_key = {std::to_string(config.bv_only) +
+                                            std::to_string(config.packed_validity) +
+                                            std::to_string(config.packed_headers)};
+    // The prelude is parsed from the same include files in every pass, so the
+    // files identify it. Their size and modification time tell two versions
+    // of an include apart.
+    prelude_key.push_back(std::to_string(prelude.size()));
+    for (const auto *node : prelude) {
+        std::string file = node->srcInfo.getSourceFile().c_str();
+        if (prelude_key.back().rfind(file + " ", 0) == 0) {
+            continue;
+        }
+        std::error_code error;
+        auto size = std::filesystem::file_size(file, error);
+        auto mtime = std::filesystem::last_write_time(file, error).time_since_epoch().count();
+        prelude_key.push_back(file + " " + std::to_string(size) + " " + std::to_string(mtime));
+    }
+    if (state.has_value() && prelude_key == key) {
+        return &*state;
+    }
+    state.reset();
+    key = prelude_key;
+    IR::Vector<IR::Node> static_decls;
+    for (const auto *node : prelude) {
+        // Constants and instances may be used in the types of the prelude.
+        if (node->is<IR::Declaration_Constant>() || node->is<IR::Declaration_Variable>() ||
+            node->is<IR::Declaration_Instance>() || node->is<IR::P4ValueSet>()) {
+            Logger::log_msg(1, "Not snapshotting the prelude, it declares variables.");
+            return nullptr;
+        }
+        if (!binds_prelude_var(node)) {
+            static_decls.push_back(node);
+        }
+    }
+    state.emplace(ctx);
+    state->set_bv_only(config.bv_only);
+    state->set_packed_validity(config.packed_validity);
+    state->set_packed_headers(config.packed_headers);
+    Z3Visitor to_z3(&*state, false);
+    (new IR::P4Program(static_decls))->apply(to_z3);
+    auto num_decls = static_decls.size();
+    Logger::log_msg(1, "Snapshotted %s prelude declarations.", num_decls);
+    return &*state;
+}
+
 MainResult get_z3_repr(const std::filesystem::path &prog_name, const IR::P4Program *program,
-                       z3::context *ctx) {
+                       z3::context *ctx, PreludeSnapshot *prelude, BlockMemo *memo,
+                       const std::shared_ptr<SimplifyCache> &simplify_cache,
+                       const CompareConfig &config, uint64_t jobs) {
     try {
         // Convert the P4 program to Z3
         P4State state(ctx);
+        state.set_bv_only(config.bv_only);
+        state.set_packed_validity(config.packed_validity);
+        state.set_packed_headers(config.packed_headers);
+        state.set_simplify_cache(simplify_cache);
+        const auto *objects = &program->objects;
+        IR::Vector<IR::Node> prelude_decls;
+        for (const auto *node : *objects) {
+            if (!is_prelude_decl(node)) {
+                break;
+            }
+            prelude_decls.push_back(node);
+        }
+        const auto *snapshot = prelude->get(ctx, prelude_decls, config);
+        if (snapshot != nullptr) {
+            // Start from the snapshot and only interpret the user declarations.
+            state.import_static_scope(*snapshot);
+            auto *remaining = new IR::Vector<IR::Node>();
+            for (const auto *node : prelude_decls) {
+                if (binds_prelude_var(node)) {
+                    remaining->push_back(node);
+                }
+            }
+            remaining->insert(remaining->end(), objects->begin() + prelude_decls.size(),
+                              objects->end());
+            objects = remaining;
+        }
         Z3Visitor to_z3(&state, false);
-        program->apply(to_z3);
+        (new IR::P4Program(program->srcInfo, *objects))->apply(to_z3);
         const auto *decl = get_main_decl(&state);
         if (decl == nullptr) {
             return {};
         }
         Z3Visitor to_z3_second(&state);
-        return gen_state_from_instance(&to_z3_second, decl);
+        memo->set_program(program);
+        return gen_state_from_instance(&to_z3_second, decl, memo, jobs);
     } catch (const Util::P4CExceptionBase &bug) {
         std::cerr << "Failed to interpret pass \"" << prog_name << "\"." << std::endl;
         std::cerr << bug.what() << std::endl;
@@ -50,15 +169,25 @@ MainResult get_z3_repr(const std::filesystem::path &prog_name, const IR::P4Progr
     return {};
 }
 
-void unroll_result(const MainResult &z3_repr_prog,
-                   std::vector<std::pair<cstring, z3::expr>> *result_vec) {
+std::vector<Z3Pipe> get_pipes(const MainResult &z3_repr_prog) {
+    std::vector<Z3Pipe> pipes;
     for (const auto &result_tuple : z3_repr_prog) {
         auto name = result_tuple.first;
         auto z3_result = result_tuple.second.first;
+        std::vector<std::pair<cstring, z3::expr>> pipe_vars;
         for (const auto &sub_tuple : z3_result) {
             auto sub_name = name + "_" + sub_tuple.first;
-            result_vec->push_back({sub_name, sub_tuple.second});
+            pipe_vars.emplace_back(sub_name, sub_tuple.second);
         }
+        pipes.emplace_back(name, pipe_vars);
+    }
+    return pipes;
+}
+
+void unroll_result(const std::vector<Z3Pipe> &pipes,
+                   std::vector<std::pair<cstring, z3::expr>> *result_vec) {
+    for (const auto &pipe : pipes) {
+        result_vec->insert(result_vec->end(), pipe.second.begin(), pipe.second.end());
     }
 }
 
@@ -81,24 +210,23 @@ z3::expr create_z3_struct(z3::context *ctx,
     return before_sort(z3_vec);
 }
 
-void print_violation_error(const z3::solver &s, const Z3Prog &prog_before,
-                           const Z3Prog &prog_after) {
+void print_violation_error(const z3::model &model, const Z3Prog &prog_before,
+                           const Z3Prog &prog_after, SimplifyCache *simplify_cache) {
     std::cerr << "Found validation error.\n";
     std::cerr << "Program " << prog_before.first << " before:\n";
     for (const auto &prog_tuple_before : prog_before.second) {
         cstring left_name = prog_tuple_before.first + ": ";
         std::cerr << std::left << std::setw(COLUMN_WIDTH) << left_name;
-        std::cerr << std::right << std::setw(COLUMN_WIDTH) << prog_tuple_before.second.simplify()
-                  << std::endl;
+        std::cerr << std::right << std::setw(COLUMN_WIDTH)
+                  << simplify_cache->simplify(prog_tuple_before.second) << std::endl;
     }
     std::cerr << "\nProgram " << prog_after.first << " after:\n";
     for (const auto &prog_tuple_after : prog_after.second) {
         cstring left_name = prog_tuple_after.first + ": ";
         std::cerr << std::left << std::setw(COLUMN_WIDTH) << left_name;
-        std::cerr << std::right << std::setw(COLUMN_WIDTH) << prog_tuple_after.second.simplify()
-                  << std::endl;
+        std::cerr << std::right << std::setw(COLUMN_WIDTH)
+                  << simplify_cache->simplify(prog_tuple_after.second) << std::endl;
     }
-    auto model = s.get_model();
     std::cerr << "\nSolution :\n";
     for (size_t idx = 0; idx < model.size(); idx++) {
         auto var = model[idx];
@@ -106,6 +234,38 @@ void print_violation_error(const z3::solver &s, const Z3Prog &prog_before,
     }
 }
 
+std::vector<DivergingOutput> get_diverging_outputs(const z3::model &model,
+                                                  const std::vector<Z3Pipe> &pipes_before,
+                                                  const std::vector<Z3Pipe> &pipes_after) {
+    std::vector<DivergingOutput> diverging;
+    for (size_t pipe_idx = 0; pipe_idx < pipes_before.size() && pipe_idx < pipes_after.size();
+         ++pipe_idx) {
+        const auto &pipe_before = pipes_before[pipe_idx];
+        const auto &pipe_after = pipes_after[pipe_idx];
+        // Output names are prefixed with the name of their pipe.
+        auto prefix_len = pipe_before.first.size() + 1;
+        for (size_t idx = 0; idx < pipe_before.second.size() && idx < pipe_after.second.size();
+             ++idx) {
+            const auto &var_before = pipe_before.second[idx];
+            const auto &var_after = pipe_after.second[idx];
+            if (var_before.first != var_after.first) {
+                continue;
+            }
+            auto value_before = model.eval(var_before.second, true);
+            auto value_after = model.eval(var_after.second, true);
+            if (z3::eq(value_before, value_after)) {
+                continue;
+            }
+            cstring name = var_before.first;
+            if (name.size() > prefix_len) {
+                name = name.substr(prefix_len);
+            }
+            diverging.push_back({pipe_before.first, name});
+        }
+    }
+    return diverging;
+}
+
 z3::expr substitute_taint(z3::context *ctx, const z3::expr &z3_var,
                           std::set<z3::expr> *taint_vars) {
     auto decl = z3_var.decl();
@@ -177,14 +337,14 @@ z3::expr substitute_taint(z3::context *ctx, const z3::expr &z3_var,
     return z3_var;
 }
 
-z3::check_result check_undefined(z3::context *ctx, z3::solver *s, const z3::expr &z3_prog_before,
-                                 const z3::expr &z3_prog_after) {
+z3::check_result check_undefined(z3::context *ctx, SimplifyCache *simplify_cache, z3::solver *s,
+                                 const z3::expr &z3_prog_before, const z3::expr &z3_prog_after) {
     auto arg_num = z3_prog_before.num_args();
     s->reset();
     for (size_t idx = 0; idx < arg_num; ++idx) {
         s->push();
-        auto m_before = z3_prog_before.arg(idx).simplify();
-        auto m_after = z3_prog_after.arg(idx).simplify();
+        auto m_before = simplify_cache->simplify(z3_prog_before.arg(idx));
+        auto m_after = simplify_cache->simplify(z3_prog_after.arg(idx));
         std::set<z3::expr> taint_vars;
         m_before = substitute_taint(ctx, m_before, &taint_vars);
         z3::expr tv_equiv = (m_before != m_after);
@@ -209,13 +369,138 @@ z3::check_result check_undefined(z3::context *ctx, z3::solver *s, const z3::expr
     return z3::check_result::unsat;
 }
 
-int compareProgs(z3::context *ctx, const std::vector<Z3Prog> &z3_progs, bool allow_undefined) {
-    z3::solver s(*ctx);
+// Collect the free input constants an expression depends on.
+void collect_free_consts(const z3::expr &expr, std::unordered_set<unsigned> *visited,
+                         std::unordered_set<unsigned> *free_consts) {
+    std::vector<z3::expr> worklist = {expr};
+    while (!worklist.empty()) {
+        auto sub_expr = worklist.back();
+        worklist.pop_back();
+        if (!visited->insert(sub_expr.id()).second || !sub_expr.is_app()) {
+            continue;
+        }
+        if (sub_expr.is_const() && sub_expr.decl().decl_kind() == Z3_OP_UNINTERPRETED) {
+            free_consts->insert(sub_expr.id());
+            continue;
+        }
+        for (unsigned idx = 0; idx < sub_expr.num_args(); ++idx) {
+            worklist.push_back(sub_expr.arg(idx));
+        }
+    }
+}
+
+// Slice the comparison of two output lists down to the outputs whose
+// expressions differ. Outputs with identical DAGs can not diverge, so the
+// inputs they share with the rest are left unconstrained. Returns no query if
+// all outputs are identical. Without slicing, the query compares all outputs,
+// so a program keeps the same state in every pair it is part of.
+std::optional<PipeQuery> slice_query(z3::context *ctx, cstring name,
+                                     const std::vector<std::pair<cstring, z3::expr>> &before,
+                                     const std::vector<std::pair<cstring, z3::expr>> &after,
+                                     bool slice) {
+    bool same_outputs = before.size() == after.size();
+    for (size_t idx = 0; same_outputs && idx < before.size(); ++idx) {
+        same_outputs = before[idx].first == after[idx].first &&
+                       z3::eq(before[idx].second.get_sort(), after[idx].second.get_sort());
+    }
+    if (!same_outputs) {
+        return PipeQuery{name, create_z3_struct(ctx, before), create_z3_struct(ctx, after)};
+    }
+    std::vector<std::pair<cstring, z3::expr>> cone_before;
+    std::vector<std::pair<cstring, z3::expr>> cone_after;
+    std::unordered_set<unsigned> visited;
+    std::unordered_set<unsigned> free_consts;
+    for (size_t idx = 0; idx < before.size(); ++idx) {
+        if (z3::eq(before[idx].second, after[idx].second)) {
+            continue;
+        }
+        cone_before.push_back(before[idx]);
+        cone_after.push_back(after[idx]);
+        if (slice && Logger::is_enabled(1)) {
+            collect_free_consts(before[idx].second, &visited, &free_consts);
+            collect_free_consts(after[idx].second, &visited, &free_consts);
+        }
+    }
+    if (cone_before.empty()) {
+        Logger::log_msg(1, "Pipe %s: identical, skipped.", name);
+        return std::nullopt;
+    }
+    if (!slice) {
+        return PipeQuery{name, create_z3_struct(ctx, before), create_z3_struct(ctx, after)};
+    }
+    auto num_outputs = before.size();
+    auto num_sliced = cone_before.size();
+    auto num_inputs = free_consts.size();
+    Logger::log_msg(1, "Pipe %s: %s of %s outputs differ, depending on %s inputs.", name,
+                    num_sliced, num_outputs, num_inputs);
+    return PipeQuery{name, create_z3_struct(ctx, cone_before), create_z3_struct(ctx, cone_after)};
+}
+
+// Split the comparison of two programs into one query per pipe. Identical
+// pipes need no query. Programs with different pipes are compared as a whole.
+std::vector<PipeQuery> get_pipe_queries(z3::context *ctx, const Z3Prog &prog_before,
+                                        const Z3Prog &prog_after,
+                                        const std::vector<Z3Pipe> &pipes_before,
+                                        const std::vector<Z3Pipe> &pipes_after, bool slice) {
+    std::vector<PipeQuery> queries;
+    bool same_pipes = pipes_before.size() == pipes_after.size();
+    for (size_t idx = 0; same_pipes && idx < pipes_before.size(); ++idx) {
+        same_pipes = pipes_before[idx].first == pipes_after[idx].first;
+    }
+    if (!same_pipes) {
+        auto query =
+            slice_query(ctx, "program"_cs, prog_before.second, prog_after.second, slice);
+        if (query.has_value()) {
+            queries.push_back(*query);
+        }
+        return queries;
+    }
+    for (size_t idx = 0; idx < pipes_before.size(); ++idx) {
+        auto query = slice_query(ctx, pipes_before[idx].first, pipes_before[idx].second,
+                                 pipes_after[idx].second, slice);
+        if (query.has_value()) {
+            queries.push_back(*query);
+        }
+    }
+    return queries;
+}
+
+int compareProgs(z3::context *ctx, const std::vector<Z3Prog> &z3_progs,
+                 const std::vector<std::vector<Z3Pipe>> &z3_pipes, const CompareConfig &config,
+                 SimplifyCache *simplify_cache, std::vector<DivergingOutput> *diverging) {
+    std::optional<PairSolver> solver;
+    try {
+        solver.emplace(ctx, config);
+    } catch (z3::exception &ex) {
+        std::cerr << "Failed to create the solver: " << ex << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto pipe_jobs = config.pipe_jobs;
+    if (pipe_jobs == 0) {
+        pipe_jobs = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    // Counterexamples collected so far, they are tried on every new pair.
+    ModelPool pool;
+    // Pairs whose equality could not be decided within the resource limits.
+    std::vector<std::pair<cstring, cstring>> unknown_pairs;
     auto prog_before = z3_progs[0];
-    auto z3_prog_before = create_z3_struct(ctx, prog_before.second);
+    auto pipes_before = z3_pipes[0];
+    auto report_violation = [&](const z3::model &model, const Z3Prog &prog_after,
+                                const std::vector<Z3Pipe> &pipes_after) {
+        print_violation_error(model, prog_before, prog_after, simplify_cache);
+        auto outputs = get_diverging_outputs(model, pipes_before, pipes_after);
+        std::cerr << "\nDiverging outputs:\n";
+        for (const auto &output : outputs) {
+            std::cerr << output.pipe << ": " << output.name << std::endl;
+        }
+        if (diverging != nullptr) {
+            *diverging = outputs;
+        }
+        return EXIT_VIOLATION;
+    };
     for (size_t i = 1; i < z3_progs.size(); ++i) {
         auto prog_after = z3_progs[i];
-        auto z3_prog_after = create_z3_struct(ctx, z3_progs[i].second);
+        auto pipes_after = z3_pipes[i];
 
         bool found = false;
         for (auto banned_pass : SKIPPED_PASSES) {
@@ -227,53 +512,102 @@ int compareProgs(z3::context *ctx, const std::vector<Z3Prog> &z3_progs, bool all
         }
         if (found) {
             prog_before = prog_after;
-            z3_prog_before = z3_prog_after;
+            pipes_before = pipes_after;
             continue;
         }
         Logger::log_msg(1, "\nComparing %s and %s.", prog_before.first, prog_after.first);
 
-        s.push();
-        s.add(z3_prog_before != z3_prog_after);
+        // Try to falsify the pair cheaply before handing it to the solver.
+        auto pool_model =
+            pool.find_counterexample(prog_before, prog_after, config.allow_undefined);
+        if (pool_model.has_value()) {
+            std::cerr << "Programs are not equal! Found by a previous counterexample."
+                      << std::endl;
+            return report_violation(*pool_model, prog_after, pipes_after);
+        }
+        auto sim_model = simulate_programs(ctx, prog_before, prog_after, config.sim_rounds,
+                                           config.allow_undefined, &pool);
+        if (sim_model.has_value()) {
+            std::cerr << "Programs are not equal! Found by random simulation." << std::endl;
+            return report_violation(*sim_model, prog_after, pipes_after);
+        }
+
         Logger::log_msg(1, "Checking... ");
-        auto ret = s.check();
-        Logger::log_msg(1, "Result: %s", ret);
-        if (ret == z3::sat) {
-            s.pop();
-            std::cerr << "Programs are not equal!" << std::endl;
-            if (allow_undefined) {
-                std::cerr << "Rechecking whether violation is caused by "
-                             "undefined behavior."
-                          << std::endl;
-                ret = check_undefined(ctx, &s, z3_prog_before, z3_prog_after);
-                if (ret != z3::unsat) {
-                    print_violation_error(s, prog_before, prog_after);
-                    return EXIT_VIOLATION;
-                }
-                prog_before = prog_after;
-                z3_prog_before = z3_prog_after;
+        // The incremental solver defines each state once and reuses it in the
+        // next pair, which only works if a program keeps the same state.
+        auto queries = get_pipe_queries(ctx, prog_before, prog_after, pipes_before, pipes_after,
+                                        !config.incremental);
+        auto verdicts = solver->check_pipes(queries, pipe_jobs);
+        bool is_unknown = false;
+        for (size_t idx = 0; idx < verdicts.size(); ++idx) {
+            const auto &verdict = verdicts[idx];
+            const auto &query = queries[idx];
+            Logger::log_msg(1, "Pipe %s: %s in %s seconds.", verdict.name, verdict.result,
+                            verdict.seconds);
+            if (verdict.result == z3::unknown) {
+                std::cerr << "Could not determine equality of " << prog_before.first << " and "
+                          << prog_after.first << " in pipe " << verdict.name << ": "
+                          << verdict.reason << std::endl;
+                is_unknown = true;
+                continue;
+            }
+            if (verdict.result != z3::sat) {
                 continue;
             }
-            print_violation_error(s, prog_before, prog_after);
-            return EXIT_VIOLATION;
+            std::cerr << "Programs are not equal in pipe " << verdict.name << "!" << std::endl;
+            if (!config.allow_undefined) {
+                return report_violation(*verdict.model, prog_after, pipes_after);
+            }
+            std::cerr << "Rechecking whether violation is caused by "
+                         "undefined behavior."
+                      << std::endl;
+            auto scratch = solver->make_scratch_solver();
+            auto ret = check_undefined(ctx, simplify_cache, &scratch, query.state_before,
+                                       query.state_after);
+            if (ret == z3::sat) {
+                return report_violation(scratch.get_model(), prog_after, pipes_after);
+            }
+            if (ret == z3::unknown) {
+                is_unknown = true;
+            } else {
+                pool.add(*verdict.model);
+            }
         }
-        if (ret == z3::unknown) {
-            std::cerr << "Error: Could not determine equality. Error" << std::endl;
-            return EXIT_FAILURE;
+        if (is_unknown) {
+            unknown_pairs.emplace_back(prog_before.first, prog_after.first);
         }
-        s.pop();
         prog_before = prog_after;
-        z3_prog_before = z3_prog_after;
+        pipes_before = pipes_after;
+    }
+    auto pool_size = pool.size();
+    Logger::log_msg(1, "Collected %s counterexample models.", pool_size);
+    if (!unknown_pairs.empty()) {
+        std::cerr << "Error: Could not determine equality of " << unknown_pairs.size()
+                  << " program pair(s):" << std::endl;
+        for (const auto &unknown_pair : unknown_pairs) {
+            std::cerr << "  " << unknown_pair.first << " -> " << unknown_pair.second << std::endl;
+        }
+        return EXIT_UNKNOWN;
     }
     Logger::log_msg(0, "Passed all checks.");
     return EXIT_SUCCESS;
 }
 
 int process_programs(const std::vector<std::filesystem::path> &prog_list, ParserOptions *options,
-                     bool allow_undefined) {
+                     const CompareConfig &config, std::vector<DivergingOutput> *diverging) {
     z3::context ctx;
     // Parse the first program
     // Use a little trick here to get the second program
     std::vector<Z3Prog> z3Progs;
+    std::vector<std::vector<Z3Pipe>> z3Pipes;
+    PreludeSnapshot prelude;
+    BlockMemo memo;
+    // All passes share the context, so they also share the simplify cache.
+    auto simplify_cache = std::make_shared<SimplifyCache>();
+    auto jobs = config.interpret_jobs;
+    if (jobs == 0) {
+        jobs = std::max(std::thread::hardware_concurrency(), 1U);
+    }
     for (auto prog : prog_list) {
         options->file = prog;
         const auto *progParsed = P4::parseP4File(*options);
@@ -281,12 +615,34 @@ int process_programs(const std::vector<std::filesystem::path> &prog_list, Parser
             std::cerr << "Unable to parse program." << std::endl;
             return EXIT_FAILURE;
         }
-        auto z3ReprProg = get_z3_repr(prog, progParsed, &ctx);
+        auto z3ReprProg =
+            get_z3_repr(prog, progParsed, &ctx, &prelude, &memo, simplify_cache, config, jobs);
+        auto pipes = get_pipes(z3ReprProg);
         std::vector<std::pair<cstring, z3::expr>> resultVec;
-        unroll_result(z3ReprProg, &resultVec);
+        unroll_result(pipes, &resultVec);
+        if (Logger::is_enabled(1)) {
+            std::unordered_set<unsigned> terms;
+            std::unordered_set<unsigned> inputs;
+            for (const auto &result : resultVec) {
+                collect_free_consts(result.second, &terms, &inputs);
+            }
+            auto num_terms = terms.size();
+            Logger::log_msg(1, "Pass %s has %s distinct output terms.", prog.filename(),
+                            num_terms);
+        }
         z3Progs.emplace_back(prog, resultVec);
+        z3Pipes.push_back(pipes);
     }
-    return compareProgs(&ctx, z3Progs, allow_undefined);
+    auto reused_blocks = memo.get_hits();
+    auto total_blocks = reused_blocks + memo.get_misses();
+    Logger::log_msg(1, "Reused %s of %s interpreted architecture blocks.", reused_blocks,
+                    total_blocks);
+    auto result = compareProgs(&ctx, z3Progs, z3Pipes, config, simplify_cache.get(), diverging);
+    auto simplify_hits = simplify_cache->get_hits();
+    auto simplify_lookups = simplify_cache->get_lookups();
+    Logger::log_msg(1, "Served %s of %s simplifications from the cache.", simplify_hits,
+                    simplify_lookups);
+    return result;
 }
 
 }  // namespace P4::ToZ3
@@ -1,6 +1,8 @@
 #ifndef TOZ3_COMPARE_COMPARE_H_
 #define TOZ3_COMPARE_COMPARE_H_
 
+#include <cstdint>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -10,9 +12,53 @@
 
 namespace P4::ToZ3 {
 using Z3Prog = std::pair<cstring, std::vector<std::pair<cstring, z3::expr>>>;
+// The outputs of one pipe of a program, for example its ingress.
+using Z3Pipe = std::pair<cstring, std::vector<std::pair<cstring, z3::expr>>>;
 constexpr auto COLUMN_WIDTH = 40;
+// Default number of random simulation batches tried before invoking the solver.
+constexpr uint64_t DEFAULT_SIM_ROUNDS = 4;
+
+// Settings that control how two programs are compared.
+struct CompareConfig {
+    // Tolerate differences caused by undefined behavior.
+    bool allow_undefined = false;
+    // Number of random simulation batches per pair, 0 disables simulation.
+    uint64_t sim_rounds = DEFAULT_SIM_ROUNDS;
+    // Per-query solver timeout in milliseconds, 0 means no limit.
+    uint64_t solver_timeout = 0;
+    // Per-query solver resource limit, 0 means no limit.
+    uint64_t solver_rlimit = 0;
+    // Semicolon-separated tactic pipeline, empty selects the default SMT core.
+    std::string solver_tactic;
+    // Race the default SMT core against a tactic pipeline on two threads.
+    bool solver_portfolio = false;
+    // Keep one solver for the whole pass chain and query pairs with assumptions.
+    bool incremental = false;
+    // Architecture blocks interpreted concurrently, 0 means one per core.
+    uint64_t interpret_jobs = 1;
+    // Pipes solved concurrently, 0 means one per core.
+    uint64_t pipe_jobs = 1;
+    // Avoid integers in the encoding, so queries stay in QF_BV.
+    bool bv_only = false;
+    // One validity bit vector per struct or stack instead of one term per header.
+    bool packed_validity = false;
+    // Headers as one bit vector each, with fields as slices of it.
+    bool packed_headers = false;
+};
+
+// An output whose value differs between two passes under a counterexample.
+struct DivergingOutput {
+    // The architecture block the output belongs to, for example the ingress.
+    cstring pipe;
+    // The output relative to the block, for example "hdr.eth.dst".
+    cstring name;
+};
+
+// Compares the passes in order. If a pair is not equal and diverging is
+// given, it receives the outputs that differ under the counterexample.
 int process_programs(const std::vector<std::filesystem::path> &prog_list, ParserOptions *options,
-                     bool allow_undefined = false);
+                     const CompareConfig &config = {},
+                     std::vector<DivergingOutput> *diverging = nullptr);
 
 }  // namespace P4::ToZ3
 
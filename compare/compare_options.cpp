@@ -0,0 +1,125 @@
+#include "compare_options.h"
+
+#include <cctype>
+#include <climits>
+#include <exception>
+#include <limits>
+#include <string>
+
+#include "lib/error.h"
+
+namespace P4::ToZ3 {
+
+bool parse_count(const char *arg, uint64_t max, uint64_t *result) {
+    std::string value(arg);
+    auto first = value.find_first_not_of(" \t");
+    if (first == std::string::npos || std::isdigit(value[first]) == 0) {
+        return false;
+    }
+    try {
+        size_t parsed = 0;
+        auto number = std::stoull(value, &parsed);
+        if (parsed != value.size() || number > max) {
+            return false;
+        }
+        *result = number;
+    } catch (const std::exception &) {
+        return false;
+    }
+    return true;
+}
+
+void register_compare_options(const OptionRegistrar &register_option, CompareConfig *config) {
+    constexpr auto NO_MAX = std::numeric_limits<uint64_t>::max();
+    // Registers an option that takes a count, named what in errors.
+    auto register_count = [&register_option](const char *option, const char *arg_name,
+                                             uint64_t *target, uint64_t max, const char *what,
+                                             const char *description) {
+        register_option(
+            option, arg_name,
+            [target, max, what](const char *arg) {
+                if (!parse_count(arg, max, target)) {
+                    P4::error("Invalid %s %s, expected a number between 0 and %s", what, arg,
+                              max);
+                    return false;
+                }
+                return true;
+            },
+            description);
+    };
+    register_option(
+        "--allow-undefined", nullptr,
+        [config](const char * /*arg*/) {
+            config->allow_undefined = true;
+            return true;
+        },
+        "Toggle to tolerate undefined behavior in comparison.");
+    register_count("--sim-rounds", "rounds", &config->sim_rounds, NO_MAX,
+                   "number of simulation rounds",
+                   "Batches of 64 random inputs to simulate before invoking the solver. "
+                   "0 disables simulation.");
+    // Z3 takes both limits as unsigned.
+    register_count("--solver-timeout", "ms", &config->solver_timeout, UINT_MAX, "solver timeout",
+                   "Timeout in milliseconds for each solver query. "
+                   "Queries that time out are reported as unknown.");
+    register_count("--solver-rlimit", "limit", &config->solver_rlimit, UINT_MAX,
+                   "solver resource limit", "Resource limit for each solver query.");
+    register_option(
+        "--solver-tactic", "tactics",
+        [config](const char *arg) {
+            config->solver_tactic = arg;
+            return true;
+        },
+        "Semicolon-separated tactic pipeline used instead of the default solver, "
+        "e.g. \"simplify;solve-eqs;bit-blast;sat\".");
+    register_option(
+        "--solver-portfolio", nullptr,
+        [config](const char * /*arg*/) {
+            config->solver_portfolio = true;
+            return true;
+        },
+        "Race the default solver against the tactic pipeline on separate threads.");
+    register_option(
+        "--incremental", nullptr,
+        [config](const char * /*arg*/) {
+            config->incremental = true;
+            return true;
+        },
+        "Assert every program state once and check pairs under assumptions, "
+        "so the solver can reuse what it learned along the pass chain.");
+    register_count("--interpret-jobs", "num", &config->interpret_jobs, NO_MAX,
+                   "number of interpreter jobs",
+                   "Number of architecture blocks interpreted concurrently in forked "
+                   "workers. 0 uses one per core. Off by default (1 interprets "
+                   "in-process): forked results are reparsed from SMT-LIB and no "
+                   "speedup has been measured yet.");
+    register_count("--pipe-jobs", "num", &config->pipe_jobs, NO_MAX, "number of pipe jobs",
+                   "Number of pipes solved concurrently, each in a solver context of its "
+                   "own. 0 uses one per core, the default of 1 solves them in turn.");
+    register_option(
+        "--bv-only", nullptr,
+        [config](const char * /*arg*/) {
+            config->bv_only = true;
+            return true;
+        },
+        "Encode stack indices and table action selectors as bit vectors instead "
+        "of integers, so that queries stay in QF_BV.");
+    register_option(
+        "--packed-validity", nullptr,
+        [config](const char * /*arg*/) {
+            config->packed_validity = true;
+            return true;
+        },
+        "Pack the validity of all headers in a struct or stack into one bit vector "
+        "instead of keeping a separate validity term per header.");
+    register_option(
+        "--packed-headers", nullptr,
+        [config](const char * /*arg*/) {
+            config->packed_headers = true;
+            return true;
+        },
+        "Represent each header as one bit vector, with fields as slices of it, "
+        "so that header copies, merges and comparisons are single terms.");
+}
+
+}  // namespace P4::ToZ3
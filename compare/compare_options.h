@@ -0,0 +1,27 @@
+#ifndef TOZ3_COMPARE_COMPARE_OPTIONS_H_
+#define TOZ3_COMPARE_COMPARE_OPTIONS_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "toz3/compare/compare.h"
+
+namespace P4::ToZ3 {
+
+// Registers a single option, forwards to the protected registerOption of the
+// options class that shares the comparison settings.
+using OptionRegistrar = std::function<void(const char *option, const char *arg_name,
+                                           std::function<bool(const char *)> processor,
+                                           const char *description)>;
+
+// Parses a non-negative number that is at most max. Unlike std::stoull,
+// negative input is rejected instead of wrapping around.
+bool parse_count(const char *arg, uint64_t max, uint64_t *result);
+
+// Registers the options that control the program comparison. They are shared
+// by p4compare and p4validate.
+void register_compare_options(const OptionRegistrar &register_option, CompareConfig *config);
+
+}  // namespace P4::ToZ3
+
+#endif  // TOZ3_COMPARE_COMPARE_OPTIONS_H_
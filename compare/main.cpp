@@ -57,5 +57,5 @@ int main(int argc, char *const argv[]) {
         options.usage();
         return EXIT_FAILURE;
     }
-    return P4::ToZ3::process_programs(progList, &options, options.undefined_is_ok);
+    return P4::ToZ3::process_programs(progList, &options, options.compare_config);
 }
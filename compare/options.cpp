@@ -1,14 +1,18 @@
 #include "options.h"
 
+#include <functional>
+#include <utility>
+
+#include "toz3/compare/compare_options.h"
+
 namespace P4::ToZ3 {
 
 CompareOptions::CompareOptions() {
-    registerOption(
-        "--allow-undefined", nullptr,
-        [this](const char * /*val*/) {
-            undefined_is_ok = true;
-            return true;
+    register_compare_options(
+        [this](const char *option, const char *arg_name,
+               std::function<bool(const char *)> processor, const char *description) {
+            registerOption(option, arg_name, std::move(processor), description);
         },
-        "Toggle to tolerate undefined behavior in comparison.");
+        &compare_config);
 }
 }  // namespace P4::ToZ3
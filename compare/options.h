@@ -3,14 +3,15 @@
 
 #include "frontends/common/options.h"
 #include "frontends/common/parser_options.h"
+#include "toz3/compare/compare.h"
 
 namespace P4::ToZ3 {
 
 class CompareOptions : public CompilerOptions {
  public:
     CompareOptions();
-    // Toggle this to allow differences in undefined behavior.
-    bool undefined_is_ok = false;
+    // Settings for the program comparison.
+    CompareConfig compare_config;
 };
 
 using P4toZ3Context = P4CContextWithOptions<CompareOptions>;
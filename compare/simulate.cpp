@@ -0,0 +1,546 @@
+#include "simulate.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+
+#include "toz3/common/util.h"
+#include "z3_api.h"
+
+namespace P4::ToZ3 {
+
+static constexpr uint64_t ALL_LANES = ~static_cast<uint64_t>(0);
+// Bits that may be set in the lanes that are biased towards small values.
+static constexpr size_t SMALL_VAL_BITS = 4;
+
+namespace {
+
+SimLanes bv_add(const SimLanes &left, const SimLanes &right, uint64_t carry) {
+    SimLanes result(left.size());
+    for (size_t idx = 0; idx < left.size(); ++idx) {
+        auto half = left[idx] ^ right[idx];
+        result[idx] = half ^ carry;
+        carry = (left[idx] & right[idx]) | (carry & half);
+    }
+    return result;
+}
+
+SimLanes bv_not(const SimLanes &val) {
+    SimLanes result(val.size());
+    for (size_t idx = 0; idx < val.size(); ++idx) {
+        result[idx] = ~val[idx];
+    }
+    return result;
+}
+
+SimLanes bv_sub(const SimLanes &left, const SimLanes &right) {
+    return bv_add(left, bv_not(right), ALL_LANES);
+}
+
+SimLanes bv_mul(const SimLanes &left, const SimLanes &right) {
+    auto width = left.size();
+    SimLanes result(width, 0);
+    SimLanes partial(width, 0);
+    for (size_t shift = 0; shift < width; ++shift) {
+        if (right[shift] == 0) {
+            continue;
+        }
+        for (size_t idx = 0; idx < width; ++idx) {
+            partial[idx] = idx >= shift ? left[idx - shift] & right[shift] : 0;
+        }
+        result = bv_add(result, partial, 0);
+    }
+    return result;
+}
+
+uint64_t bv_eq(const SimLanes &left, const SimLanes &right) {
+    uint64_t result = ALL_LANES;
+    for (size_t idx = 0; idx < left.size(); ++idx) {
+        result &= ~(left[idx] ^ right[idx]);
+    }
+    return result;
+}
+
+// Unsigned less-than, a < b holds iff a + ~b + 1 does not carry out.
+uint64_t bv_ult(const SimLanes &left, const SimLanes &right) {
+    uint64_t carry = ALL_LANES;
+    for (size_t idx = 0; idx < left.size(); ++idx) {
+        auto inv = ~right[idx];
+        carry = (left[idx] & inv) | (carry & (left[idx] ^ inv));
+    }
+    return ~carry;
+}
+
+// Signed comparison is unsigned comparison with flipped sign bits.
+uint64_t bv_slt(SimLanes left, SimLanes right) {
+    left.back() = ~left.back();
+    right.back() = ~right.back();
+    return bv_ult(left, right);
+}
+
+enum class ShiftKind { Left, LogicalRight, ArithRight };
+
+SimLanes bv_shift(const SimLanes &val, const SimLanes &amount, ShiftKind kind) {
+    auto width = val.size();
+    auto fill = kind == ShiftKind::ArithRight ? val.back() : 0;
+    SimLanes result = val;
+    SimLanes shifted(width);
+    uint64_t overflow = 0;
+    // Barrel shifter, stage k conditionally shifts by 2^k.
+    for (size_t stage = 0; stage < amount.size(); ++stage) {
+        auto sel = amount[stage];
+        if (stage >= 63 || (static_cast<uint64_t>(1) << stage) >= width) {
+            overflow |= sel;
+            continue;
+        }
+        size_t dist = static_cast<size_t>(1) << stage;
+        for (size_t idx = 0; idx < width; ++idx) {
+            if (kind == ShiftKind::Left) {
+                shifted[idx] = idx >= dist ? result[idx - dist] : 0;
+            } else {
+                shifted[idx] = idx + dist < width ? result[idx + dist] : fill;
+            }
+        }
+        for (size_t idx = 0; idx < width; ++idx) {
+            result[idx] = (sel & shifted[idx]) | (~sel & result[idx]);
+        }
+    }
+    for (auto &bit : result) {
+        bit = (overflow & fill) | (~overflow & bit);
+    }
+    return result;
+}
+
+}  // namespace
+
+void BitSimulator::add_literals(const z3::expr &expr) {
+    if (!literal_visited.insert(expr.id()).second) {
+        return;
+    }
+    std::string bits;
+    if (expr.is_numeral() && expr.get_sort().is_bv() && expr.as_binary(bits)) {
+        std::reverse(bits.begin(), bits.end());
+        if (std::find(literals.begin(), literals.end(), bits) == literals.end()) {
+            literals.push_back(bits);
+        }
+        return;
+    }
+    if (expr.is_app()) {
+        for (unsigned idx = 0; idx < expr.num_args(); ++idx) {
+            add_literals(expr.arg(idx));
+        }
+    }
+}
+
+void BitSimulator::next_batch() {
+    inputs.clear();
+    cache.clear();
+}
+
+bool is_undefined(const z3::expr &expr, std::unordered_map<unsigned, bool> *cache) {
+    auto it = cache->find(expr.id());
+    if (it != cache->end()) {
+        return it->second;
+    }
+    bool result = false;
+    if (expr.is_const() && !expr.is_numeral()) {
+        result = expr.decl().name().str().find(UNDEF_LABEL) != std::string::npos;
+    } else if (expr.is_app()) {
+        for (unsigned idx = 0; idx < expr.num_args() && !result; ++idx) {
+            result = is_undefined(expr.arg(idx), cache);
+        }
+    }
+    cache->emplace(expr.id(), result);
+    return result;
+}
+
+bool BitSimulator::is_undefined(const z3::expr &expr) {
+    return ToZ3::is_undefined(expr, &undef_cache);
+}
+
+const SimLanes &BitSimulator::gen_input(const z3::expr &expr) {
+    auto sort = expr.get_sort();
+    size_t width = sort.is_bv() ? sort.bv_size() : 1;
+    SimLanes planes(width);
+    for (auto &plane : planes) {
+        plane = rng();
+    }
+    if (sort.is_bv()) {
+        // Uniform values rarely hit equality checks, so bias a share of the
+        // lanes towards zero, all ones, small values and program literals.
+        auto zero_mask = rng() & rng() & rng();
+        auto ones_mask = rng() & rng() & rng() & ~zero_mask;
+        auto small_mask = rng() & rng() & rng() & ~(zero_mask | ones_mask);
+        uint64_t lit_mask = 0;
+        if (!literals.empty()) {
+            lit_mask = rng() & rng() & ~(zero_mask | ones_mask | small_mask);
+        }
+        for (size_t idx = 0; idx < width; ++idx) {
+            planes[idx] = (planes[idx] & ~zero_mask) | ones_mask;
+            if (idx >= SMALL_VAL_BITS) {
+                planes[idx] &= ~small_mask;
+            }
+        }
+        for (uint64_t lane = 0; lane < SIM_LANES; ++lane) {
+            auto lane_bit = static_cast<uint64_t>(1) << lane;
+            if ((lit_mask & lane_bit) == 0) {
+                continue;
+            }
+            const auto &lit = literals[rng() % literals.size()];
+            for (size_t idx = 0; idx < width; ++idx) {
+                if (idx < lit.size() && lit[idx] == '1') {
+                    planes[idx] |= lane_bit;
+                } else {
+                    planes[idx] &= ~lane_bit;
+                }
+            }
+        }
+    }
+    auto result = inputs.emplace(expr.id(), std::make_pair(expr, std::move(planes)));
+    return result.first->second.second;
+}
+
+const SimLanes *BitSimulator::eval(const z3::expr &expr) {
+    auto id = expr.id();
+    auto it = cache.find(id);
+    if (it == cache.end()) {
+        it = cache.emplace(id, eval_app(expr)).first;
+    }
+    return it->second ? &*it->second : nullptr;
+}
+
+std::optional<SimLanes> BitSimulator::eval_app(const z3::expr &expr) {
+    if (!expr.is_app()) {
+        return std::nullopt;
+    }
+    auto sort = expr.get_sort();
+    if (!sort.is_bool() && !sort.is_bv()) {
+        return std::nullopt;
+    }
+    auto decl = expr.decl();
+    auto kind = decl.decl_kind();
+    switch (kind) {
+        case Z3_OP_TRUE:
+            return SimLanes{ALL_LANES};
+        case Z3_OP_FALSE:
+            return SimLanes{0};
+        case Z3_OP_BNUM: {
+            std::string bits;
+            if (!expr.as_binary(bits)) {
+                return std::nullopt;
+            }
+            SimLanes result(sort.bv_size(), 0);
+            for (size_t idx = 0; idx < bits.size() && idx < result.size(); ++idx) {
+                result[idx] = bits[bits.size() - 1 - idx] == '1' ? ALL_LANES : 0;
+            }
+            return result;
+        }
+        case Z3_OP_UNINTERPRETED: {
+            if (expr.num_args() != 0) {
+                return std::nullopt;
+            }
+            return gen_input(expr);
+        }
+        default:
+            break;
+    }
+
+    std::vector<const SimLanes *> args;
+    for (unsigned idx = 0; idx < expr.num_args(); ++idx) {
+        const auto *arg = eval(expr.arg(idx));
+        if (arg == nullptr) {
+            return std::nullopt;
+        }
+        args.push_back(arg);
+    }
+    if (args.empty()) {
+        return std::nullopt;
+    }
+    const auto &first = *args[0];
+    auto width = first.size();
+
+    switch (kind) {
+        case Z3_OP_NOT:
+        case Z3_OP_BNOT:
+            return bv_not(first);
+        case Z3_OP_AND:
+        case Z3_OP_BAND: {
+            SimLanes result = first;
+            for (size_t arg = 1; arg < args.size(); ++arg) {
+                for (size_t idx = 0; idx < width; ++idx) {
+                    result[idx] &= (*args[arg])[idx];
+                }
+            }
+            return result;
+        }
+        case Z3_OP_OR:
+        case Z3_OP_BOR: {
+            SimLanes result = first;
+            for (size_t arg = 1; arg < args.size(); ++arg) {
+                for (size_t idx = 0; idx < width; ++idx) {
+                    result[idx] |= (*args[arg])[idx];
+                }
+            }
+            return result;
+        }
+        case Z3_OP_XOR:
+        case Z3_OP_BXOR: {
+            SimLanes result = first;
+            for (size_t arg = 1; arg < args.size(); ++arg) {
+                for (size_t idx = 0; idx < width; ++idx) {
+                    result[idx] ^= (*args[arg])[idx];
+                }
+            }
+            return result;
+        }
+        case Z3_OP_BNAND:
+        case Z3_OP_BNOR:
+        case Z3_OP_BXNOR: {
+            SimLanes result(width);
+            for (size_t idx = 0; idx < width; ++idx) {
+                auto left = first[idx];
+                auto right = (*args[1])[idx];
+                if (kind == Z3_OP_BNAND) {
+                    result[idx] = ~(left & right);
+                } else if (kind == Z3_OP_BNOR) {
+                    result[idx] = ~(left | right);
+                } else {
+                    result[idx] = ~(left ^ right);
+                }
+            }
+            return result;
+        }
+        case Z3_OP_IMPLIES:
+            return SimLanes{~first[0] | (*args[1])[0]};
+        case Z3_OP_EQ:
+        case Z3_OP_IFF:
+            return SimLanes{bv_eq(first, *args[1])};
+        case Z3_OP_BCOMP:
+            return SimLanes{bv_eq(first, *args[1])};
+        case Z3_OP_DISTINCT: {
+            uint64_t result = ALL_LANES;
+            for (size_t left = 0; left < args.size(); ++left) {
+                for (size_t right = left + 1; right < args.size(); ++right) {
+                    result &= ~bv_eq(*args[left], *args[right]);
+                }
+            }
+            return SimLanes{result};
+        }
+        case Z3_OP_ITE: {
+            auto cond = first[0];
+            const auto &then_val = *args[1];
+            const auto &else_val = *args[2];
+            SimLanes result(then_val.size());
+            for (size_t idx = 0; idx < then_val.size(); ++idx) {
+                result[idx] = (cond & then_val[idx]) | (~cond & else_val[idx]);
+            }
+            return result;
+        }
+        case Z3_OP_BNEG:
+            return bv_sub(SimLanes(width, 0), first);
+        case Z3_OP_BADD: {
+            SimLanes result = first;
+            for (size_t arg = 1; arg < args.size(); ++arg) {
+                result = bv_add(result, *args[arg], 0);
+            }
+            return result;
+        }
+        case Z3_OP_BSUB:
+            return bv_sub(first, *args[1]);
+        case Z3_OP_BMUL: {
+            SimLanes result = first;
+            for (size_t arg = 1; arg < args.size(); ++arg) {
+                result = bv_mul(result, *args[arg]);
+            }
+            return result;
+        }
+        case Z3_OP_CONCAT: {
+            // The first argument holds the most significant bits.
+            SimLanes result;
+            for (auto it = args.rbegin(); it != args.rend(); ++it) {
+                result.insert(result.end(), (*it)->begin(), (*it)->end());
+            }
+            return result;
+        }
+        case Z3_OP_EXTRACT:
+            return SimLanes(first.begin() + expr.lo(), first.begin() + expr.hi() + 1);
+        case Z3_OP_ZERO_EXT:
+        case Z3_OP_SIGN_EXT: {
+            auto ext = static_cast<size_t>(Z3_get_decl_int_parameter(*ctx, decl, 0));
+            SimLanes result = first;
+            result.resize(width + ext, kind == Z3_OP_SIGN_EXT ? first.back() : 0);
+            return result;
+        }
+        case Z3_OP_REPEAT: {
+            auto count = static_cast<size_t>(Z3_get_decl_int_parameter(*ctx, decl, 0));
+            SimLanes result;
+            for (size_t idx = 0; idx < count; ++idx) {
+                result.insert(result.end(), first.begin(), first.end());
+            }
+            return result;
+        }
+        case Z3_OP_BREDOR:
+        case Z3_OP_BREDAND: {
+            uint64_t result = kind == Z3_OP_BREDAND ? ALL_LANES : 0;
+            for (auto bit : first) {
+                result = kind == Z3_OP_BREDAND ? result & bit : result | bit;
+            }
+            return SimLanes{result};
+        }
+        case Z3_OP_ULT:
+            return SimLanes{bv_ult(first, *args[1])};
+        case Z3_OP_ULEQ:
+            return SimLanes{~bv_ult(*args[1], first)};
+        case Z3_OP_UGT:
+            return SimLanes{bv_ult(*args[1], first)};
+        case Z3_OP_UGEQ:
+            return SimLanes{~bv_ult(first, *args[1])};
+        case Z3_OP_SLT:
+            return SimLanes{bv_slt(first, *args[1])};
+        case Z3_OP_SLEQ:
+            return SimLanes{~bv_slt(*args[1], first)};
+        case Z3_OP_SGT:
+            return SimLanes{bv_slt(*args[1], first)};
+        case Z3_OP_SGEQ:
+            return SimLanes{~bv_slt(first, *args[1])};
+        case Z3_OP_BSHL:
+            return bv_shift(first, *args[1], ShiftKind::Left);
+        case Z3_OP_BLSHR:
+            return bv_shift(first, *args[1], ShiftKind::LogicalRight);
+        case Z3_OP_BASHR:
+            return bv_shift(first, *args[1], ShiftKind::ArithRight);
+        default:
+            // Division, remainder, integers, and datatypes are left to the
+            // solver.
+            return std::nullopt;
+    }
+}
+
+z3::model BitSimulator::get_model(uint64_t lane) const {
+    z3::model model(*ctx);
+    for (const auto &input : inputs) {
+        const auto &var = input.second.first;
+        const auto &planes = input.second.second;
+        auto decl = var.decl();
+        if (var.get_sort().is_bool()) {
+            auto value = ctx->bool_val(((planes[0] >> lane) & 1) != 0);
+            model.add_const_interp(decl, value);
+            continue;
+        }
+        auto bits = std::make_unique<bool[]>(planes.size());
+        for (size_t idx = 0; idx < planes.size(); ++idx) {
+            bits[idx] = ((planes[idx] >> lane) & 1) != 0;
+        }
+        auto value = ctx->bv_val(planes.size(), bits.get());
+        model.add_const_interp(decl, value);
+    }
+    return model;
+}
+
+void ModelPool::add(const z3::model &model) {
+    if (models.size() >= MAX_POOL_MODELS) {
+        models.pop_front();
+    }
+    models.push_back(model);
+}
+
+std::optional<z3::model> ModelPool::find_counterexample(const Z3Prog &prog_before,
+                                                        const Z3Prog &prog_after,
+                                                        bool allow_undefined) {
+    const auto &outputs_before = prog_before.second;
+    const auto &outputs_after = prog_after.second;
+    if (models.empty() || outputs_before.size() != outputs_after.size()) {
+        return std::nullopt;
+    }
+    std::vector<z3::expr> diffs;
+    for (size_t idx = 0; idx < outputs_before.size(); ++idx) {
+        const auto &before = outputs_before[idx].second;
+        const auto &after = outputs_after[idx].second;
+        if (z3::eq(before, after) || !z3::eq(before.get_sort(), after.get_sort())) {
+            continue;
+        }
+        if (allow_undefined &&
+            (is_undefined(before, &undef_cache) || is_undefined(after, &undef_cache))) {
+            continue;
+        }
+        diffs.push_back(before != after);
+    }
+    // Try the most recent models first, they are most likely to still apply.
+    for (auto it = models.rbegin(); it != models.rend(); ++it) {
+        for (const auto &diff : diffs) {
+            if (it->eval(diff, true).is_true()) {
+                return *it;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<z3::model> simulate_programs(z3::context *ctx, const Z3Prog &prog_before,
+                                           const Z3Prog &prog_after, uint64_t rounds,
+                                           bool allow_undefined, ModelPool *pool) {
+    const auto &outputs_before = prog_before.second;
+    const auto &outputs_after = prog_after.second;
+    if (rounds == 0 || outputs_before.size() != outputs_after.size()) {
+        return std::nullopt;
+    }
+    BitSimulator sim(ctx);
+    // Candidate output pairs and whether they depend on undefined values.
+    std::vector<std::tuple<z3::expr, z3::expr, bool>> candidates;
+    for (size_t idx = 0; idx < outputs_before.size(); ++idx) {
+        const auto &before = outputs_before[idx].second;
+        const auto &after = outputs_after[idx].second;
+        // Identical ASTs can never diverge.
+        if (z3::eq(before, after) || !z3::eq(before.get_sort(), after.get_sort())) {
+            continue;
+        }
+        // Divergence in undefined values has to be judged by the solver.
+        bool undef = allow_undefined && (sim.is_undefined(before) || sim.is_undefined(after));
+        if (undef && pool == nullptr) {
+            continue;
+        }
+        sim.add_literals(before);
+        sim.add_literals(after);
+        candidates.emplace_back(before, after, undef);
+    }
+    for (uint64_t round = 0; round < rounds && !candidates.empty(); ++round) {
+        sim.next_batch();
+        for (auto it = candidates.begin(); it != candidates.end();) {
+            const auto &[before, after, undef] = *it;
+            const auto *lanes_before = sim.eval(before);
+            const auto *lanes_after = sim.eval(after);
+            if (lanes_before == nullptr || lanes_after == nullptr) {
+                it = candidates.erase(it);
+                continue;
+            }
+            uint64_t diff = 0;
+            for (size_t idx = 0; idx < lanes_before->size(); ++idx) {
+                diff |= (*lanes_before)[idx] ^ (*lanes_after)[idx];
+            }
+            if (diff != 0) {
+                uint64_t lane = 0;
+                while (((diff >> lane) & 1) == 0) {
+                    lane++;
+                }
+                auto model = sim.get_model(lane);
+                // Only trust the simulator if the model confirms the result.
+                if (!model.eval(before != after, true).is_true()) {
+                    Logger::log_msg(1, "Simulation mismatch could not be confirmed.");
+                } else if (undef) {
+                    // Keep the probe, it may expose a real violation later.
+                    pool->add(model);
+                    it = candidates.erase(it);
+                    continue;
+                } else {
+                    Logger::log_msg(1, "Simulation found a counterexample in round %s.", round);
+                    return model;
+                }
+            }
+            ++it;
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace P4::ToZ3
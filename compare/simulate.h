@@ -0,0 +1,90 @@
+#ifndef TOZ3_COMPARE_SIMULATE_H_
+#define TOZ3_COMPARE_SIMULATE_H_
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../contrib/z3/z3++.h"
+#include "compare.h"
+
+namespace P4::ToZ3 {
+
+// Number of input assignments evaluated in a single simulation pass.
+constexpr uint64_t SIM_LANES = 64;
+// Fixed seed so that simulation results are reproducible.
+constexpr uint64_t SIM_SEED = 0x70347a33;
+// Maximum number of counterexample models kept for reuse.
+constexpr size_t MAX_POOL_MODELS = 32;
+
+// A bit-sliced value. Word i holds bit i of the value for all lanes.
+// Booleans are represented by a single word.
+using SimLanes = std::vector<uint64_t>;
+
+class BitSimulator {
+ private:
+    z3::context *ctx;
+    std::mt19937_64 rng;
+    // Numerals found in the expressions, stored least significant bit first.
+    std::vector<std::string> literals;
+    // The free constants of the current batch, keyed by their AST id.
+    std::unordered_map<unsigned, std::pair<z3::expr, SimLanes>> inputs;
+    // Evaluated nodes of the current batch. Unsupported nodes map to nullopt.
+    std::unordered_map<unsigned, std::optional<SimLanes>> cache;
+    std::unordered_map<unsigned, bool> undef_cache;
+    std::unordered_set<unsigned> literal_visited;
+
+    const SimLanes &gen_input(const z3::expr &expr);
+    std::optional<SimLanes> eval_app(const z3::expr &expr);
+
+ public:
+    explicit BitSimulator(z3::context *ctx, uint64_t seed = SIM_SEED) : ctx(ctx), rng(seed) {}
+    // Record the numerals of the expression, they are used to bias the input.
+    void add_literals(const z3::expr &expr);
+    // Draw a fresh batch of input assignments.
+    void next_batch();
+    // Evaluate the expression for all lanes of the current batch. Returns
+    // nullptr if the expression contains an unsupported operation.
+    const SimLanes *eval(const z3::expr &expr);
+    // Whether the expression references an undefined value.
+    bool is_undefined(const z3::expr &expr);
+    // Convert the input assignment of a single lane into a model.
+    z3::model get_model(uint64_t lane) const;
+};
+
+// Whether the expression references an undefined value. Results are memoized
+// in the cache, keyed by AST id.
+bool is_undefined(const z3::expr &expr, std::unordered_map<unsigned, bool> *cache);
+
+// Models that distinguished earlier program pairs. Later pairs are evaluated
+// against these models before any more expensive check is run.
+class ModelPool {
+ private:
+    std::deque<z3::model> models;
+    std::unordered_map<unsigned, bool> undef_cache;
+
+ public:
+    void add(const z3::model &model);
+    // Returns the first pooled model under which the programs diverge.
+    std::optional<z3::model> find_counterexample(const Z3Prog &prog_before,
+                                                 const Z3Prog &prog_after, bool allow_undefined);
+    size_t size() const { return models.size(); }
+};
+
+// Evaluate the outputs of both programs on rounds * SIM_LANES random inputs.
+// Returns a model that is a confirmed counterexample if the programs diverge.
+// Mismatches that are caused by undefined values are not reported but their
+// models are added to the pool, if one is given.
+std::optional<z3::model> simulate_programs(z3::context *ctx, const Z3Prog &prog_before,
+                                           const Z3Prog &prog_after, uint64_t rounds,
+                                           bool allow_undefined, ModelPool *pool = nullptr);
+
+}  // namespace P4::ToZ3
+
+#endif  // TOZ3_COMPARE_SIMULATE_H_
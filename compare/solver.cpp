@@ -0,0 +1,278 @@
+#include "solver.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "toz3/common/util.h"
+#include "z3_api.h"
+
+namespace P4::ToZ3 {
+
+namespace {
+
+// Express the state disequality member-wise. Tactic pipelines such as
+// bit-blast do not support the tuple sort of the state.
+z3::expr get_member_divergence(const z3::expr &state_before, const z3::expr &state_after) {
+    if (state_before.num_args() != state_after.num_args() ||
+        !z3::eq(state_before.get_sort(), state_after.get_sort())) {
+        return state_before != state_after;
+    }
+    z3::expr_vector diffs(state_before.ctx());
+    for (unsigned idx = 0; idx < state_before.num_args(); ++idx) {
+        diffs.push_back(state_before.arg(idx) != state_after.arg(idx));
+    }
+    return z3::mk_or(diffs);
+}
+
+z3::expr translate(const z3::expr &expr, z3::context *dst_ctx) {
+    return {*dst_ctx, Z3_translate(expr.ctx(), expr, *dst_ctx)};
+}
+
+// A pipe query translated into a context of its own.
+struct PipeTask {
+    CompareConfig config;
+    z3::context ctx;
+    std::optional<PairSolver> solver;
+    std::optional<z3::expr> state_before;
+    std::optional<z3::expr> state_after;
+    z3::check_result result = z3::unknown;
+    double seconds = 0;
+};
+
+}  // namespace
+
+PairSolver::PairSolver(z3::context *ctx, const CompareConfig &config)
+    : ctx(ctx), config(config), solver(make_solver(ctx, config.solver_tactic)) {
+    if (config.incremental && (config.solver_portfolio || !config.solver_tactic.empty())) {
+        Logger::log_msg(0, "Incremental mode requires the default solver, ignoring it.");
+    }
+}
+
+z3::params PairSolver::get_params(z3::context *solver_ctx) const {
+    z3::params params(*solver_ctx);
+    if (config.solver_timeout > 0) {
+        params.set("timeout", static_cast<unsigned>(config.solver_timeout));
+    }
+    if (config.solver_rlimit > 0) {
+        params.set("rlimit", static_cast<unsigned>(config.solver_rlimit));
+    }
+    return params;
+}
+
+z3::solver PairSolver::make_solver(z3::context *solver_ctx, const std::string &tactic) const {
+    std::optional<z3::tactic> pipeline;
+    std::stringstream steps(tactic);
+    std::string step;
+    while (std::getline(steps, step, ';')) {
+        auto begin = step.find_first_not_of(' ');
+        if (begin == std::string::npos) {
+            continue;
+        }
+        auto end = step.find_last_not_of(' ');
+        z3::tactic next(*solver_ctx, step.substr(begin, end - begin + 1).c_str());
+        pipeline = pipeline.has_value() ? *pipeline & next : next;
+    }
+    std::optional<z3::solver> solver;
+    if (pipeline.has_value()) {
+        solver = pipeline->mk_solver();
+    } else if (config.bv_only && !config.incremental) {
+        // Queries are member-wise and free of integers, skip the tuple theory.
+        solver = z3::solver(*solver_ctx, "QF_BV");
+    } else {
+        solver = z3::solver(*solver_ctx);
+    }
+    solver->set(get_params(solver_ctx));
+    return *solver;
+}
+
+z3::check_result PairSolver::check(const z3::expr &state_before, const z3::expr &state_after) {
+    model.reset();
+    reason.clear();
+    if (config.solver_portfolio) {
+        auto query = config.bv_only ? get_member_divergence(state_before, state_after)
+                                    : state_before != state_after;
+        return check_portfolio(query, get_member_divergence(state_before, state_after));
+    }
+    if (config.solver_tactic.empty()) {
+        if (config.incremental) {
+            return check_incremental(state_before, state_after);
+        }
+        if (!config.bv_only) {
+            return check_single(state_before != state_after);
+        }
+    }
+    return check_single(get_member_divergence(state_before, state_after));
+}
+
+std::vector<PipeVerdict> PairSolver::check_pipes(const std::vector<PipeQuery> &queries,
+                                                 uint64_t jobs) {
+    std::vector<PipeVerdict> verdicts;
+    // Incremental mode shares its definitions across pipes, so it stays in
+    // the main context.
+    if (jobs <= 1 || queries.size() <= 1 || config.incremental) {
+        for (const auto &query : queries) {
+            PipeVerdict verdict{query.name, z3::unknown, std::nullopt, "", 0};
+            auto start = std::chrono::steady_clock::now();
+            verdict.result = check(query.state_before, query.state_after);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            verdict.seconds = elapsed.count();
+            if (verdict.result == z3::sat) {
+                verdict.model = get_model();
+            } else if (verdict.result == z3::unknown) {
+                verdict.reason = reason_unknown();
+            }
+            verdicts.push_back(verdict);
+        }
+        return verdicts;
+    }
+
+    // Contexts are not thread-safe, so all translations happen here.
+    std::vector<std::unique_ptr<PipeTask>> tasks;
+    for (const auto &query : queries) {
+        auto task = std::make_unique<PipeTask>();
+        task->config = config;
+        task->solver.emplace(&task->ctx, task->config);
+        task->state_before = translate(query.state_before, &task->ctx);
+        task->state_after = translate(query.state_after, &task->ctx);
+        tasks.push_back(std::move(task));
+    }
+    std::atomic<size_t> next_task = 0;
+    auto run = [&]() {
+        size_t idx = 0;
+        while ((idx = next_task++) < tasks.size()) {
+            auto &task = *tasks[idx];
+            auto start = std::chrono::steady_clock::now();
+            try {
+                task.result = task.solver->check(*task.state_before, *task.state_after);
+            } catch (const z3::exception &) {
+                task.result = z3::unknown;
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            task.seconds = elapsed.count();
+        }
+    };
+    std::vector<std::thread> workers;
+    auto num_workers = std::min<size_t>(jobs, tasks.size());
+    for (size_t idx = 0; idx < num_workers; ++idx) {
+        workers.emplace_back(run);
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    for (size_t idx = 0; idx < tasks.size(); ++idx) {
+        auto &task = *tasks[idx];
+        PipeVerdict verdict{queries[idx].name, task.result, std::nullopt, "", 0};
+        verdict.seconds = task.seconds;
+        if (task.result == z3::sat) {
+            auto pipe_model = task.solver->get_model();
+            verdict.model = z3::model(pipe_model, *ctx, z3::model::translate());
+        } else if (task.result == z3::unknown) {
+            verdict.reason = task.solver->reason_unknown();
+        }
+        verdicts.push_back(verdict);
+    }
+    return verdicts;
+}
+
+z3::check_result PairSolver::check_single(const z3::expr &query) {
+    solver.push();
+    solver.add(query);
+    auto ret = solver.check();
+    if (ret == z3::sat) {
+        model = solver.get_model();
+    } else if (ret == z3::unknown) {
+        reason = solver.reason_unknown();
+    }
+    solver.pop();
+    return ret;
+}
+
+const PairSolver::StateDefinition &PairSolver::get_definition(const z3::expr &state) {
+    auto it = definitions.find(state.id());
+    if (it != definitions.end()) {
+        return it->second;
+    }
+    auto idx = std::to_string(definitions.size());
+    auto state_const = ctx->constant(("state_" + idx).c_str(), state.get_sort());
+    auto guard = ctx->bool_const(("def_" + idx).c_str());
+    solver.add(z3::implies(guard, state_const == state));
+    auto definition = StateDefinition{state, state_const, guard};
+    return definitions.emplace(state.id(), definition).first->second;
+}
+
+z3::check_result PairSolver::check_incremental(const z3::expr &state_before,
+                                               const z3::expr &state_after) {
+    // Every state is defined once and shared by the two pairs it is part of,
+    // so lemmas about common subterms survive from one query to the next.
+    const auto &def_before = get_definition(state_before);
+    const auto &def_after = get_definition(state_after);
+    auto query = ctx->bool_const(("query_" + std::to_string(query_count++)).c_str());
+    solver.add(z3::implies(query, def_before.state_const != def_after.state_const));
+    z3::expr_vector assumptions(*ctx);
+    assumptions.push_back(def_before.guard);
+    assumptions.push_back(def_after.guard);
+    assumptions.push_back(query);
+    auto ret = solver.check(assumptions);
+    if (ret == z3::sat) {
+        model = solver.get_model();
+    } else if (ret == z3::unknown) {
+        reason = solver.reason_unknown();
+    }
+    // Retire the query, it is never asked again.
+    solver.add(!query);
+    return ret;
+}
+
+z3::check_result PairSolver::check_portfolio(const z3::expr &query, const z3::expr &bv_query) {
+    // Every configuration runs in a context of its own, so the loser can be
+    // interrupted without leaving the main context in a canceled state.
+    std::array<z3::context, 2> race_ctxs;
+    std::string tactic =
+        config.solver_tactic.empty() ? DEFAULT_PORTFOLIO_TACTIC : config.solver_tactic;
+    std::vector<z3::solver> solvers;
+    solvers.push_back(make_solver(&race_ctxs[0], ""));
+    solvers.push_back(make_solver(&race_ctxs[1], tactic));
+    solvers[0].add(translate(query, &race_ctxs[0]));
+    solvers[1].add(translate(bv_query, &race_ctxs[1]));
+
+    std::array<z3::check_result, 2> results = {z3::unknown, z3::unknown};
+    std::atomic<bool> decided = false;
+    auto run = [&](size_t idx) {
+        try {
+            results[idx] = solvers[idx].check();
+        } catch (const z3::exception &) {
+            results[idx] = z3::unknown;
+        }
+        if (results[idx] != z3::unknown && !decided.exchange(true)) {
+            race_ctxs[1 - idx].interrupt();
+        }
+    };
+    std::thread racer(run, 1);
+    run(0);
+    racer.join();
+
+    for (size_t idx = 0; idx < results.size(); ++idx) {
+        if (results[idx] == z3::unknown) {
+            continue;
+        }
+        cstring winner = idx == 0 ? "SMT core"_cs : cstring(tactic);
+        Logger::log_msg(1, "Portfolio decided by %s.", winner);
+        if (results[idx] == z3::sat) {
+            auto race_model = solvers[idx].get_model();
+            model = z3::model(race_model, *ctx, z3::model::translate());
+        }
+        return results[idx];
+    }
+    reason = solvers[0].reason_unknown();
+    return z3::unknown;
+}
+
+}  // namespace P4::ToZ3
@@ -0,0 +1,78 @@
+#ifndef TOZ3_COMPARE_SOLVER_H_
+#define TOZ3_COMPARE_SOLVER_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../contrib/z3/z3++.h"
+#include "compare.h"
+
+namespace P4::ToZ3 {
+
+// Tactic pipeline raced against the default SMT core in portfolio mode.
+constexpr auto DEFAULT_PORTFOLIO_TACTIC = "simplify;solve-eqs;bit-blast;sat";
+
+// The states of one pipe (ingress, egress, ...) before and after a pass.
+struct PipeQuery {
+    cstring name;
+    z3::expr state_before;
+    z3::expr state_after;
+};
+
+// The outcome of a pipe query.
+struct PipeVerdict {
+    cstring name;
+    z3::check_result result = z3::unknown;
+    std::optional<z3::model> model;
+    std::string reason;
+    double seconds = 0;
+};
+
+// Decides whether two program states can diverge. Wraps the configured
+// solver, its resource limits, and the optional portfolio.
+class PairSolver {
+ private:
+    z3::context *ctx;
+    const CompareConfig &config;
+    z3::solver solver;
+    std::optional<z3::model> model;
+    std::string reason;
+    // A program state whose definition was asserted in incremental mode.
+    struct StateDefinition {
+        // Keeps the state alive, so that its AST id is not reused.
+        z3::expr state;
+        z3::expr state_const;
+        z3::expr guard;
+    };
+    // Asserted definitions keyed by the AST id of the state.
+    std::unordered_map<unsigned, StateDefinition> definitions;
+    uint64_t query_count = 0;
+
+    z3::params get_params(z3::context *solver_ctx) const;
+    z3::solver make_solver(z3::context *solver_ctx, const std::string &tactic) const;
+    const StateDefinition &get_definition(const z3::expr &state);
+    z3::check_result check_single(const z3::expr &query);
+    z3::check_result check_incremental(const z3::expr &state_before, const z3::expr &state_after);
+    z3::check_result check_portfolio(const z3::expr &query, const z3::expr &bv_query);
+
+ public:
+    PairSolver(z3::context *ctx, const CompareConfig &config);
+    // Check whether the two states differ under some input.
+    z3::check_result check(const z3::expr &state_before, const z3::expr &state_after);
+    // The model of the last satisfiable check.
+    const z3::model &get_model() const { return *model; }
+    // The reason the last check returned unknown.
+    const std::string &reason_unknown() const { return reason; }
+    // Check every pipe on its own. With more than one job, the pipes are
+    // solved concurrently, each in a context of its own.
+    std::vector<PipeVerdict> check_pipes(const std::vector<PipeQuery> &queries, uint64_t jobs);
+    // A fresh solver with the same configuration, for one-off checks.
+    z3::solver make_scratch_solver() const { return make_solver(ctx, config.solver_tactic); }
+};
+
+}  // namespace P4::ToZ3
+
+#endif  // TOZ3_COMPARE_SOLVER_H_
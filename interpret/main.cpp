@@ -61,7 +61,7 @@ int main(int argc, char *const argv[]) {
                 std::cout << "Pipe " << pipeName << " state:" << std::endl;
                 for (const auto &tuple : pipeVars) {
                     auto name = tuple.first;
-                    auto var = tuple.second.simplify();
+                    auto var = state.simplify(tuple.second);
                     std::cout << name << ": " << var << "\n";
                 }
             } else {
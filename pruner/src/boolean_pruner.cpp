@@ -1,7 +1,10 @@
 #include "boolean_pruner.h"
 
+#include <cstdint>
 #include <cstdlib>
+#include <vector>
 
+#include "progress.h"
 #include "toz3/pruner/src/constants.h"
 #include "toz3/pruner/src/pruner_util.h"
 
@@ -35,10 +38,13 @@ const IR::P4Program *prune_bool_expressions(const IR::P4Program *program,
     int same_before_pruning = 0;
     int result = 0;
     INFO("\nReducing boolean expressions")
-    for (int i = 0; i < PRUNER_MAX_ITERS; i++) {
-        const auto *temp = program;
-        temp = remove_bool_expressions(temp);
-        result = check_pruned_program(&program, temp, pruner_conf);
+    Progress::instance().set_phase("boolean expressions");
+    for (int i = 0; i < PRUNER_MAX_ITERS && !budget_exhausted(pruner_conf); i++) {
+        std::vector<const IR::P4Program *> candidates;
+        for (uint64_t job = 0; job < pruner_conf.jobs; ++job) {
+            candidates.push_back(remove_bool_expressions(program));
+        }
+        result = check_pruned_programs(&program, candidates, pruner_conf);
         if (result != EXIT_SUCCESS) {
             same_before_pruning++;
         } else {
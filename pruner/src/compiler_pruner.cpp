@@ -14,6 +14,7 @@
 #include "frontends/p4/typeMap.h"
 #include "ir/pass_manager.h"
 #include "lib/error_reporter.h"
+#include "progress.h"
 #include "replace_variables.h"
 #include "toz3/pruner/src/pruner_util.h"
 
@@ -65,6 +66,7 @@ const IR::P4Program *apply_compiler_passes(const IR::P4Program *program, PrunerC
     auto action = DiagnosticAction::Ignore;
     P4CContext::get().setDefaultWarningDiagnosticAction(action);
     INFO("\nPruning with compiler passes")
+    Progress::instance().set_phase("compiler passes");
     bool genericPassesApplied = false;
     // apply the compiler passes
     program = apply_generic_passes(program, pruner_conf, &genericPassesApplied);
@@ -0,0 +1,268 @@
+#include "compiler_spawner.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+
+namespace P4::ToZ3::Pruner {
+
+namespace {
+
+constexpr size_t CHUNK_SIZE = 4096;
+// How often the spawner checks whether a compiler that closed its output
+// has exited.
+constexpr int WAIT_STEP_MS = 10;
+
+bool write_all(int fd, const void *data, size_t len) {
+    const auto *buf = static_cast<const char *>(data);
+    while (len > 0) {
+        auto written = send(fd, buf, len, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        buf += written;
+        len -= written;
+    }
+    return true;
+}
+
+bool read_all(int fd, void *data, size_t len) {
+    auto *buf = static_cast<char *>(data);
+    while (len > 0) {
+        auto received = read(fd, buf, len);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        buf += received;
+        len -= received;
+    }
+    return true;
+}
+
+// The spawner loop. It only uses fixed buffers and system calls, the pruner
+// state it inherited is never touched.
+[[noreturn]] void serve(int fd, const char *compiler, const char *include_arg) {
+    std::array<char, PATH_MAX> path{};
+    std::array<char, CHUNK_SIZE> chunk{};
+    uint32_t timeout = 0;
+    uint32_t path_len = 0;
+    while (read_all(fd, &timeout, sizeof(timeout)) &&
+           read_all(fd, &path_len, sizeof(path_len)) && path_len < path.size() &&
+           read_all(fd, path.data(), path_len)) {
+        path[path_len] = '\0';
+        std::array<int, 2> out{};
+        if (pipe(out.data()) != 0) {
+            break;
+        }
+        pid_t child = fork();
+        if (child == 0) {
+            // Same as running the compiler with 2>&1.
+            dup2(out[1], STDOUT_FILENO);
+            dup2(out[1], STDERR_FILENO);
+            close(out[0]);
+            close(out[1]);
+            close(fd);
+            // Its own process group, so a timeout kills anything it started.
+            setpgid(0, 0);
+            execl(compiler, compiler, "--Wdisable", include_arg, path.data(), nullptr);
+            _exit(EXIT_FAILURE);
+        }
+        close(out[1]);
+        int status = EXIT_FAILURE << 8;
+        if (child > 0) {
+            setpgid(child, child);
+            // The spawner enforces the timeout itself with SIGKILL, like
+            // timeout -s KILL does, so the compiler cannot ignore it.
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+            bool killed = false;
+            // Milliseconds left before the compiler is killed, -1 if there
+            // is no limit and 0 once it has been killed.
+            auto wait_ms = [&]() {
+                if (timeout == 0) {
+                    return -1;
+                }
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                deadline - std::chrono::steady_clock::now())
+                                .count();
+                if (!killed && left <= 0) {
+                    kill(-child, SIGKILL);
+                    killed = true;
+                }
+                return killed ? 0 : static_cast<int>(std::min<int64_t>(left, INT_MAX));
+            };
+            pollfd output{out[0], POLLIN, 0};
+            while (true) {
+                auto polled = poll(&output, 1, wait_ms());
+                if (polled < 0 && errno != EINTR) {
+                    break;
+                }
+                // Only drain what a killed compiler left in the pipe.
+                if (polled == 0 && killed) {
+                    break;
+                }
+                if (polled <= 0) {
+                    continue;
+                }
+                auto received = read(out[0], chunk.data(), chunk.size());
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (received <= 0) {
+                    break;
+                }
+                auto chunk_len = static_cast<uint32_t>(received);
+                write_all(fd, &chunk_len, sizeof(chunk_len));
+                write_all(fd, chunk.data(), chunk_len);
+            }
+            pid_t waited = 0;
+            while ((waited = waitpid(child, &status, WNOHANG)) == 0) {
+                auto left = wait_ms();
+                if (left <= 0) {
+                    waited = waitpid(child, &status, 0);
+                    break;
+                }
+                poll(nullptr, 0, std::min(left, WAIT_STEP_MS));
+            }
+            if (waited < 0) {
+                status = EXIT_FAILURE << 8;
+            }
+        }
+        close(out[0]);
+        uint32_t end = 0;
+        write_all(fd, &end, sizeof(end));
+        write_all(fd, &status, sizeof(status));
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+}  // namespace
+
+bool CompilerSpawner::start(const std::string &compiler, const std::string &include_arg) {
+    std::array<int, 2> sockets{};
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets.data()) != 0) {
+        return false;
+    }
+    pid = fork();
+    if (pid == 0) {
+        close(sockets[0]);
+        serve(sockets[1], compiler.c_str(), include_arg.c_str());
+    }
+    close(sockets[1]);
+    if (pid < 0) {
+        close(sockets[0]);
+        return false;
+    }
+    fd = sockets[0];
+    return true;
+}
+
+void CompilerSpawner::stop() {
+    if (!is_running()) {
+        return;
+    }
+    // The spawner exits once its socket is closed.
+    close(fd);
+    waitpid(pid, nullptr, 0);
+    fd = -1;
+    pid = -1;
+}
+
+std::optional<ExitInfo> CompilerSpawner::run(const std::filesystem::path &file, uint32_t timeout) {
+    std::string path = file;
+    auto path_len = static_cast<uint32_t>(path.size());
+    if (!write_all(fd, &timeout, sizeof(timeout)) ||
+        !write_all(fd, &path_len, sizeof(path_len)) || !write_all(fd, path.data(), path_len)) {
+        return std::nullopt;
+    }
+    ExitInfo exit_info;
+    std::array<char, CHUNK_SIZE> chunk{};
+    uint32_t chunk_len = 0;
+    while (true) {
+        if (!read_all(fd, &chunk_len, sizeof(chunk_len)) || chunk_len > chunk.size()) {
+            return std::nullopt;
+        }
+        if (chunk_len == 0) {
+            break;
+        }
+        if (!read_all(fd, chunk.data(), chunk_len)) {
+            return std::nullopt;
+        }
+        exit_info.err_msg.append(chunk.data(), chunk_len);
+    }
+    int status = 0;
+    if (!read_all(fd, &status, sizeof(status))) {
+        return std::nullopt;
+    }
+    // A compiler killed by a signal gets the exit code a shell reports for
+    // it, as it would through popen.
+    if (WIFSIGNALED(status)) {
+        exit_info.exit_code = 128 + WTERMSIG(status);
+    } else {
+        exit_info.exit_code = WEXITSTATUS(status);
+    }
+    return exit_info;
+}
+
+CompilerSpawnerPool::~CompilerSpawnerPool() {
+    // Later spawners inherited the sockets of earlier ones, so they have to
+    // go first for the earlier ones to see their socket close.
+    for (auto spawner = spawners.rbegin(); spawner != spawners.rend(); ++spawner) {
+        spawner->stop();
+    }
+}
+
+void CompilerSpawnerPool::start(const PrunerConfig &pruner_conf, size_t num_spawners) {
+    std::string include_arg = "-I" + get_include_dir();
+    for (size_t idx = 0; idx < num_spawners; ++idx) {
+        CompilerSpawner spawner;
+        if (!spawner.start(pruner_conf.compiler, include_arg)) {
+            INFO("Could not start a compiler spawner, falling back to popen.");
+            break;
+        }
+        spawners.push_back(spawner);
+        busy.push_back(false);
+    }
+}
+
+std::optional<ExitInfo> CompilerSpawnerPool::run(const std::filesystem::path &file,
+                                            uint32_t timeout) {
+    size_t idx = 0;
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        released.wait(guard, [this, &idx]() {
+            for (idx = 0; idx < busy.size(); ++idx) {
+                if (!busy[idx]) {
+                    return true;
+                }
+            }
+            return false;
+        });
+        busy[idx] = true;
+    }
+    auto exit_info = spawners[idx].run(file, timeout);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        busy[idx] = false;
+    }
+    released.notify_one();
+    return exit_info;
+}
+
+}  // namespace P4::ToZ3::Pruner
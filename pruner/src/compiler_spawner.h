@@ -0,0 +1,62 @@
+#ifndef _PRUNER_SRC_COMPILER_SPAWNER_H
+#define _PRUNER_SRC_COMPILER_SPAWNER_H
+
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "pruner_util.h"
+
+namespace P4::ToZ3::Pruner {
+
+// A small helper process that is forked off the pruner before the program
+// is parsed. For every candidate it spawns the compiler, without a shell,
+// and streams back its output and exit status. The compiler still starts
+// from scratch for every candidate, only forking the (large) pruner process
+// and spawning a shell are avoided.
+class CompilerSpawner {
+ private:
+    pid_t pid = -1;
+    // Our end of the socket pair shared with the server.
+    int fd = -1;
+
+ public:
+    CompilerSpawner() = default;
+    bool start(const std::string &compiler, const std::string &include_arg);
+    void stop();
+    bool is_running() const { return pid > 0; }
+    // Compiles the file, returns nothing if the spawner is gone. A timeout
+    // in seconds kills the compiler, 0 means no limit.
+    std::optional<ExitInfo> run(const std::filesystem::path &file, uint32_t timeout);
+};
+
+// One compiler spawner per concurrent job.
+class CompilerSpawnerPool {
+ private:
+    std::vector<CompilerSpawner> spawners;
+    std::vector<bool> busy;
+    std::mutex lock;
+    std::condition_variable released;
+
+ public:
+    static CompilerSpawnerPool &instance() {
+        static CompilerSpawnerPool instance;
+
+        return instance;
+    }
+    ~CompilerSpawnerPool();
+    void start(const PrunerConfig &pruner_conf, size_t num_spawners);
+    bool is_running() const { return !spawners.empty(); }
+    std::optional<ExitInfo> run(const std::filesystem::path &file, uint32_t timeout);
+};
+
+}  // namespace P4::ToZ3::Pruner
+
+#endif /* _PRUNER_SRC_COMPILER_SPAWNER_H */
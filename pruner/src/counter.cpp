@@ -2,7 +2,13 @@
 namespace P4::ToZ3::Pruner {
 Visitor::profile_t Counter::init_apply(const IR::Node *node) { return Inspector::init_apply(node); }
 
+bool Counter::preorder(const IR::Node * /*n*/) {
+    nodes++;
+    return true;
+}
+
 bool Counter::preorder(const IR::Statement * /*s*/) {
+    nodes++;
     statements++;
     return true;
 }
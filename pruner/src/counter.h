@@ -11,10 +11,15 @@ namespace P4::ToZ3::Pruner {
 class Counter : public Inspector {
  public:
     Visitor::profile_t init_apply(const IR::Node *node) override;
+    bool preorder(const IR::Node *n) override;
     bool preorder(const IR::Statement *s) override;
+    uint64_t nodes;
     uint64_t statements;
 
-    Counter() { statements = 0; }
+    Counter() {
+        nodes = 0;
+        statements = 0;
+    }
 };
 }  // namespace P4::ToZ3::Pruner
 #endif /* _PRUNER_SRC_COUNTER_H */
@@ -0,0 +1,64 @@
+#ifndef _PRUNER_SRC_DDMIN_H
+#define _PRUNER_SRC_DDMIN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace P4::ToZ3::Pruner {
+
+// Delta debugging over a bank of removable items. try_removal receives a
+// subset of the bank and returns whether the bug persists without it, in
+// which case the removal is kept. Returns the items that could not be
+// removed, which are 1-minimal: none of them can be removed on its own.
+// Reduction ends early, without that guarantee, once stop returns true.
+template <typename T>
+std::vector<T> ddmin(std::vector<T> bank,
+                     const std::function<bool(const std::vector<T> &)> &try_removal,
+                     const std::function<bool()> &stop = []() { return false; }) {
+    auto without_chunk = [](const std::vector<T> &items, size_t begin, size_t end) {
+        std::vector<T> rest(items.begin(), items.begin() + begin);
+        rest.insert(rest.end(), items.begin() + end, items.end());
+        return rest;
+    };
+    size_t chunks = 2;
+    while (!bank.empty() && !stop()) {
+        chunks = std::min(chunks, bank.size());
+        bool reduced = false;
+        // First try to remove a single chunk.
+        for (size_t idx = 0; idx < chunks && !reduced; ++idx) {
+            size_t begin = idx * bank.size() / chunks;
+            size_t end = (idx + 1) * bank.size() / chunks;
+            std::vector<T> chunk(bank.begin() + begin, bank.begin() + end);
+            if (try_removal(chunk)) {
+                bank = without_chunk(bank, begin, end);
+                chunks = std::max<size_t>(chunks - 1, 2);
+                reduced = true;
+            }
+        }
+        // Then try to remove everything but a single chunk. With two chunks
+        // the complement is the other chunk, which was already tried.
+        for (size_t idx = 0; idx < chunks && chunks > 2 && !reduced; ++idx) {
+            size_t begin = idx * bank.size() / chunks;
+            size_t end = (idx + 1) * bank.size() / chunks;
+            if (try_removal(without_chunk(bank, begin, end))) {
+                bank = std::vector<T>(bank.begin() + begin, bank.begin() + end);
+                chunks = 2;
+                reduced = true;
+            }
+        }
+        if (reduced) {
+            continue;
+        }
+        if (chunks >= bank.size()) {
+            break;
+        }
+        chunks = std::min(chunks * 2, bank.size());
+    }
+    return bank;
+}
+
+}  // namespace P4::ToZ3::Pruner
+
+#endif /* _PRUNER_SRC_DDMIN_H */
@@ -1,11 +1,13 @@
 #include "expression_pruner.h"
 
+#include <cstdint>
 #include <cstdlib>
 #include <string>
 #include <vector>
 
 #include "ir/vector.h"
 #include "lib/cstring.h"
+#include "progress.h"
 #include "toz3/pruner/src/constants.h"
 #include "toz3/pruner/src/pruner_util.h"
 
@@ -90,10 +92,13 @@ const IR::P4Program *prune_expressions(const IR::P4Program *program, PrunerConfi
     int same_before_pruning = 0;
     int result = 0;
     INFO("\nPruning expressions");
-    for (int i = 0; i < PRUNER_MAX_ITERS; i++) {
-        const auto *temp = program;
-        temp = remove_expressions(program);
-        result = check_pruned_program(&program, temp, pruner_conf);
+    Progress::instance().set_phase("expressions");
+    for (int i = 0; i < PRUNER_MAX_ITERS && !budget_exhausted(pruner_conf); i++) {
+        std::vector<const IR::P4Program *> candidates;
+        for (uint64_t job = 0; job < pruner_conf.jobs; ++job) {
+            candidates.push_back(remove_expressions(program));
+        }
+        result = check_pruned_programs(&program, candidates, pruner_conf);
         if (result != EXIT_SUCCESS) {
             same_before_pruning++;
         } else {
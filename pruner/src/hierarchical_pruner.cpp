@@ -0,0 +1,160 @@
+#include "hierarchical_pruner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boolean_pruner.h"
+#include "ddmin.h"
+#include "expression_pruner.h"
+#include "progress.h"
+#include "statement_pruner.h"
+#include "toz3/pruner/src/constants.h"
+#include "toz3/pruner/src/pruner_util.h"
+
+namespace P4::ToZ3::Pruner {
+
+namespace {
+
+// Counts the nodes of a subtree, used to try the largest removals first.
+class NodeCounter : public Inspector {
+ public:
+    uint64_t nodes = 0;
+    bool preorder(const IR::Node * /*n*/) override {
+        nodes++;
+        return true;
+    }
+};
+
+}  // namespace
+
+const char *level_name(PruneLevel level) {
+    switch (level) {
+        case PruneLevel::Controls:
+            return "parsers and controls";
+        case PruneLevel::Tables:
+            return "tables";
+        case PruneLevel::Actions:
+            return "actions";
+        case PruneLevel::StructFields:
+            return "struct fields";
+        case PruneLevel::Blocks:
+            return "nested blocks";
+    }
+    return "unknown";
+}
+
+NodeRemover::NodeRemover(const std::unordered_set<int> &_to_remove) : to_remove(_to_remove) {
+    setName("NodeRemover");
+}
+
+const IR::Node *NodeRemover::preorder(IR::Node *n) {
+    if (to_remove.count(n->clone_id) == 0) {
+        return n;
+    }
+    // Statements of an if statement can not be removed, only emptied.
+    if (n->is<IR::Statement>() && getParent<IR::IfStatement>() != nullptr) {
+        return new IR::EmptyStatement();
+    }
+    return nullptr;
+}
+
+bool LevelCollector::preorder(const IR::Node *n) {
+    bool matches = false;
+    switch (level) {
+        case PruneLevel::Controls:
+            matches = n->is<IR::P4Control>() || n->is<IR::P4Parser>();
+            break;
+        case PruneLevel::Tables:
+            matches = n->is<IR::P4Table>();
+            break;
+        case PruneLevel::Actions:
+            matches = n->is<IR::P4Action>();
+            break;
+        case PruneLevel::StructFields:
+            matches = n->is<IR::StructField>();
+            break;
+        case PruneLevel::Blocks:
+            // Bodies of controls and actions must stay, only nested blocks
+            // and branches can be removed.
+            matches = (n->is<IR::BlockStatement>() || n->is<IR::IfStatement>() ||
+                       n->is<IR::SwitchStatement>()) &&
+                      (getParent<IR::BlockStatement>() != nullptr ||
+                       getParent<IR::IfStatement>() != nullptr);
+            break;
+    }
+    if (matches) {
+        nodes.push_back(n);
+    }
+    return true;
+}
+
+// Returns the clone ids of the nodes, largest subtrees first so that the
+// first chunks tried by delta debugging are the most rewarding ones.
+std::vector<int> order_by_size(const std::vector<const IR::Node *> &nodes) {
+    std::vector<std::pair<uint64_t, int>> sized;
+    for (const auto *n : nodes) {
+        NodeCounter counter;
+        n->apply(counter);
+        sized.emplace_back(counter.nodes, n->clone_id);
+    }
+    std::stable_sort(sized.begin(), sized.end(),
+                     [](const auto &a, const auto &b) { return a.first > b.first; });
+    std::vector<int> ids;
+    for (const auto &entry : sized) {
+        ids.push_back(entry.second);
+    }
+    return ids;
+}
+
+const IR::P4Program *prune_level(const IR::P4Program *program, PruneLevel level,
+                                 const PrunerConfig &pruner_conf) {
+    auto calls_before = oracle_call_count();
+    LevelCollector collector(level);
+    program->apply(collector);
+    if (collector.nodes.empty()) {
+        return program;
+    }
+    auto ids = order_by_size(collector.nodes);
+    INFO("\nPruning " << level_name(level) << ", " << ids.size() << " candidates");
+    Progress::instance().set_phase(level_name(level));
+    std::function<bool(const std::vector<int> &)> try_removal =
+        [&program, &pruner_conf](const std::vector<int> &chunk) {
+            std::unordered_set<int> to_remove(chunk.begin(), chunk.end());
+            NodeRemover remover(to_remove);
+            const auto *temp = program->apply(remover);
+            return check_pruned_program(&program, temp, pruner_conf) == EXIT_SUCCESS;
+        };
+    auto needed =
+        ddmin(ids, try_removal, [&pruner_conf]() { return budget_exhausted(pruner_conf); });
+    INFO("Removed " << ids.size() - needed.size() << " " << level_name(level)
+                    << " with " << oracle_call_count() - calls_before << " oracle calls");
+    return program;
+}
+
+const IR::P4Program *prune_hierarchically(const IR::P4Program *program,
+                                          const PrunerConfig &pruner_conf) {
+    for (int round = 0; round < PRUNER_MAX_ITERS && !budget_exhausted(pruner_conf); round++) {
+        auto &progress = Progress::instance();
+        auto size_before = progress.get_current().chars;
+        for (auto level : PRUNE_LEVELS) {
+            program = prune_level(program, level, pruner_conf);
+        }
+        program = prune_statements(program, pruner_conf, progress.get_current().statements);
+        program = prune_expressions(program, pruner_conf);
+        program = prune_bool_expressions(program, pruner_conf);
+        if (progress.get_current().chars >= size_before) {
+            // Fixed point, no level could remove anything this round.
+            break;
+        }
+        INFO("Hierarchical round " << round << " reduced the program, repeating");
+    }
+    return program;
+}
+
+}  // namespace P4::ToZ3::Pruner
@@ -0,0 +1,52 @@
+#ifndef _HIERARCHICAL_PRUNER_H
+#define _HIERARCHICAL_PRUNER_H
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/node.h"
+#include "ir/visitor.h"
+#include "pruner_util.h"
+
+namespace P4::ToZ3::Pruner {
+
+// The declaration levels of the hierarchical pruner, coarsest first.
+enum class PruneLevel : uint32_t { Controls, Tables, Actions, StructFields, Blocks };
+constexpr std::array<PruneLevel, 5> PRUNE_LEVELS = {PruneLevel::Controls, PruneLevel::Tables,
+                                                     PruneLevel::Actions, PruneLevel::StructFields,
+                                                     PruneLevel::Blocks};
+const char *level_name(PruneLevel level);
+
+// Removes every node whose clone id is listed. Transforms keep the clone id
+// of the nodes they copy, so the ids stay valid across accepted programs.
+class NodeRemover : public Transform {
+ public:
+    const std::unordered_set<int> &to_remove;
+    explicit NodeRemover(const std::unordered_set<int> &to_remove);
+    const IR::Node *preorder(IR::Node *n) override;
+};
+
+// Collects all nodes of a level.
+class LevelCollector : public Inspector {
+ public:
+    explicit LevelCollector(PruneLevel _level) : level(_level) { setName("LevelCollector"); }
+    bool preorder(const IR::Node *n) override;
+    PruneLevel level;
+    std::vector<const IR::Node *> nodes;
+};
+
+// Removes the nodes of a single level with delta debugging.
+const IR::P4Program *prune_level(const IR::P4Program *program, PruneLevel level,
+                                 const PrunerConfig &pruner_conf);
+
+// Prunes coarse-to-fine until no level makes progress anymore: whole
+// parsers and controls, tables, actions, struct fields and nested blocks,
+// followed by statements, expressions and boolean expressions.
+const IR::P4Program *prune_hierarchically(const IR::P4Program *program,
+                                          const PrunerConfig &pruner_conf);
+
+}  // namespace P4::ToZ3::Pruner
+
+#endif /* _HIERARCHICAL_PRUNER_H */
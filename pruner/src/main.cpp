@@ -11,25 +11,40 @@
 
 #include "boolean_pruner.h"
 #include "compiler_pruner.h"
+#include "compiler_spawner.h"
 #include "contrib/json.h"
 #include "expression_pruner.h"
 #include "frontends/common/options.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/common/parser_options.h"
+#include "hierarchical_pruner.h"
 #include "ir/ir.h"
 #include "lib/compile_context.h"
 #include "lib/error.h"
+#include "phase_scheduler.h"
+#include "progress.h"
 #include "pruner_options.h"
 #include "pruner_util.h"
+#include "slice_pruner.h"
 #include "statement_pruner.h"
+#include "validation_oracle.h"
 
 namespace P4::ToZ3::Pruner {
 
 const IR::P4Program *prune(const IR::P4Program *program, const PrunerConfig &pruner_conf,
                            uint64_t prog_size) {
-    program = prune_statements(program, pruner_conf, prog_size);
-    program = prune_expressions(program, pruner_conf);
-    program = prune_bool_expressions(program, pruner_conf);
+    if (pruner_conf.slice) {
+        program = prune_slice(program, pruner_conf);
+    }
+    if (pruner_conf.max_oracle_calls != 0 || pruner_conf.time_budget != 0) {
+        program = prune_within_budget(program, get_prune_phases(pruner_conf), pruner_conf);
+    } else if (pruner_conf.hierarchical) {
+        program = prune_hierarchically(program, pruner_conf);
+    } else {
+        program = prune_statements(program, pruner_conf, prog_size);
+        program = prune_expressions(program, pruner_conf);
+        program = prune_bool_expressions(program, pruner_conf);
+    }
     program = apply_compiler_passes(program, pruner_conf);
     return program;
 }
@@ -133,6 +148,35 @@ PrunerConfig get_conf_from_script(const PrunerOptions &options) {
     return get_config_from_json(conf_file, options.working_dir, options.file.c_str(), options);
 }
 
+PrunerConfig get_conf_in_process(const PrunerOptions &options) {
+    INFO("Grabbing config by validating in-process.");
+    if (!std::filesystem::exists(options.compiler_bin.value())) {
+        P4::error("Path to compiler binary %s invalid! Exiting.", options.compiler_bin.value());
+        exit(EXIT_FAILURE);
+    }
+    PrunerConfig pruner_conf;
+
+    pruner_conf.compiler = options.compiler_bin.value();
+    pruner_conf.working_dir = options.working_dir;
+    pruner_conf.in_process = true;
+    if (options.output_file.has_value()) {
+        pruner_conf.out_file_name = options.output_file.value();
+    } else {
+        pruner_conf.out_file_name =
+            std::filesystem::path(options.file.c_str()).replace_extension().string() +
+            "_stripped.p4";
+    }
+    // auto-fill the exit info from validating the input program
+    auto exit_info = validate_in_process(options.file.c_str(), pruner_conf);
+    if (exit_info.exit_code == EXIT_SUCCESS) {
+        P4::warning("There was no error. Pruning will yield bogus results.");
+    }
+
+    pruner_conf.exit_code = exit_info.exit_code;
+    pruner_conf.err_string = exit_info.err_msg;
+    return pruner_conf;
+}
+
 PrunerConfig get_conf_from_compiler(const PrunerOptions &options) {
     INFO("Grabbing config by using the compiler binary.");
     if (!std::filesystem::exists(options.compiler_bin.value())) {
@@ -209,7 +253,14 @@ int main(int argc, char *const argv[]) {
                 "CRASH for crash bug");
             exit(EXIT_FAILURE);
         }
-        if (error_type == P4::ToZ3::Pruner::ErrorType::SemanticBug) {
+        if (error_type == P4::ToZ3::Pruner::ErrorType::SemanticBug && options.in_process) {
+            if (!options.compiler_bin.has_value()) {
+                P4::error("Need to provide a compiler binary to prune a validation bug");
+                options.usage();
+                return EXIT_FAILURE;
+            }
+            pruner_conf = get_conf_in_process(options);
+        } else if (error_type == P4::ToZ3::Pruner::ErrorType::SemanticBug) {
             if (!(options.validation_bin.has_value() && options.compiler_bin.has_value())) {
                 P4::error(
                     "Need to provide both a validation binary and a compiler "
@@ -234,6 +285,13 @@ int main(int argc, char *const argv[]) {
         }
     }
 
+    pruner_conf.jobs = options.jobs;
+    pruner_conf.ddmin = options.ddmin;
+    pruner_conf.hierarchical = options.hierarchical;
+    pruner_conf.slice = options.slice;
+    pruner_conf.in_process = options.in_process;
+    pruner_conf.max_oracle_calls = options.max_oracle_calls;
+    pruner_conf.time_budget = options.time_budget;
     // create the working dir
     std::filesystem::create_directories(pruner_conf.working_dir);
 
@@ -243,6 +301,18 @@ int main(int argc, char *const argv[]) {
     exit_info.err_msg = pruner_conf.err_string;
     // this should probably become part of the initial setup later
     pruner_conf.err_type = classify_bug(exit_info);
+    // The slice needs the outputs the validator reports to diverge.
+    if (pruner_conf.slice &&
+        pruner_conf.err_type != P4::ToZ3::Pruner::ErrorType::SemanticBug) {
+        P4::error("--slice only applies to validation bugs");
+        options.usage();
+        return EXIT_FAILURE;
+    }
+    if (pruner_conf.err_type == P4::ToZ3::Pruner::ErrorType::CrashBug &&
+        options.compiler_spawner) {
+        // Start the spawners before the program is parsed, so they stay small.
+        P4::ToZ3::Pruner::CompilerSpawnerPool::instance().start(pruner_conf, pruner_conf.jobs);
+    }
 
     try {
         // if a seed was provided, use it
@@ -253,7 +323,10 @@ int main(int argc, char *const argv[]) {
 
         if (program != nullptr && P4::errorCount() == 0) {
             const auto *original = program;
-            double prog_size = P4::ToZ3::Pruner::count_statements(original);
+            auto &progress = P4::ToZ3::Pruner::Progress::instance();
+            progress.start(original, P4::ToZ3::Pruner::get_accepted_text(original).length(),
+                           options.progress_file.value_or(""));
+            auto prog_size = progress.get_initial().statements;
             INFO("Size of the program :" << prog_size << " statements");
 
             program = prune(program, pruner_conf, prog_size);
@@ -264,8 +337,12 @@ int main(int argc, char *const argv[]) {
             if (!options.dry_run) {
                 P4::ToZ3::Pruner::emit_p4_program(program, pruner_conf.out_file_name);
             }
-            INFO("Total reduction percentage = " << P4::ToZ3::Pruner::measure_pct(original, program)
-                                                 << " %");
+            INFO("Total reduction percentage = " << progress.reduction_pct() << " %");
+            INFO("Remaining: " << progress.get_current().nodes << " nodes, "
+                               << progress.get_current().statements << " statements");
+            INFO("Oracle calls: " << P4::ToZ3::Pruner::oracle_call_count() << ", answered from "
+                                  << P4::ToZ3::Pruner::cached_verdict_count()
+                                  << " cached verdicts");
         }
         INFO("Done.");
     } catch (const std::exception &bug) {
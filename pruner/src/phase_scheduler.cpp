@@ -0,0 +1,102 @@
+#include "phase_scheduler.h"
+
+#include <cstdint>
+#include <ostream>
+
+#include "boolean_pruner.h"
+#include "expression_pruner.h"
+#include "hierarchical_pruner.h"
+#include "progress.h"
+#include "statement_pruner.h"
+
+namespace P4::ToZ3::Pruner {
+
+std::vector<PrunePhase> get_prune_phases(const PrunerConfig &pruner_conf) {
+    std::vector<PrunePhase> phases;
+    if (pruner_conf.hierarchical) {
+        for (auto level : PRUNE_LEVELS) {
+            PrunePhase phase;
+            phase.name = level_name(level);
+            phase.run = [level, pruner_conf](const IR::P4Program *program) {
+                return prune_level(program, level, pruner_conf);
+            };
+            phases.push_back(phase);
+        }
+    }
+    PrunePhase statements;
+    statements.name = "statements";
+    statements.run = [pruner_conf](const IR::P4Program *program) {
+        return prune_statements(program, pruner_conf,
+                                Progress::instance().get_current().statements);
+    };
+    phases.push_back(statements);
+    PrunePhase expressions;
+    expressions.name = "expressions";
+    expressions.run = [pruner_conf](const IR::P4Program *program) {
+        return prune_expressions(program, pruner_conf);
+    };
+    phases.push_back(expressions);
+    PrunePhase bool_expressions;
+    bool_expressions.name = "boolean expressions";
+    bool_expressions.run = [pruner_conf](const IR::P4Program *program) {
+        return prune_bool_expressions(program, pruner_conf);
+    };
+    phases.push_back(bool_expressions);
+    return phases;
+}
+
+PrunePhase *pick_phase(std::vector<PrunePhase> *phases) {
+    PrunePhase *best = nullptr;
+    double best_rate = -1;
+    for (auto &phase : *phases) {
+        if (phase.runs == 0) {
+            return &phase;
+        }
+        if (phase.stalled) {
+            continue;
+        }
+        double rate = phase.seconds > 0 ? phase.removed_chars / phase.seconds : phase.removed_chars;
+        if (rate > best_rate) {
+            best = &phase;
+            best_rate = rate;
+        }
+    }
+    return best;
+}
+
+const IR::P4Program *prune_within_budget(const IR::P4Program *program,
+                                         std::vector<PrunePhase> phases,
+                                         const PrunerConfig &pruner_conf) {
+    auto &progress = Progress::instance();
+    while (!budget_exhausted(pruner_conf)) {
+        auto *phase = pick_phase(&phases);
+        if (phase == nullptr) {
+            // Fixed point, no phase can remove anything anymore.
+            break;
+        }
+        auto chars_before = progress.get_current().chars;
+        auto start = progress.elapsed_seconds();
+        program = phase->run(program);
+        auto chars_after = progress.get_current().chars;
+        uint64_t removed = chars_before > chars_after ? chars_before - chars_after : 0;
+        phase->seconds += progress.elapsed_seconds() - start;
+        phase->removed_chars += removed;
+        phase->runs++;
+        if (removed == 0) {
+            phase->stalled = true;
+        } else {
+            // The program changed, so every phase may find something again.
+            for (auto &other : phases) {
+                other.stalled = false;
+            }
+        }
+        INFO("Phase " << phase->name << " removed " << phase->removed_chars << " characters in "
+                      << phase->seconds << " seconds so far");
+    }
+    if (budget_exhausted(pruner_conf)) {
+        INFO("Pruning budget exhausted, keeping the best program found.");
+    }
+    return program;
+}
+
+}  // namespace P4::ToZ3::Pruner
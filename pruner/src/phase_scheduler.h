@@ -0,0 +1,38 @@
+#ifndef _PRUNER_SRC_PHASE_SCHEDULER_H
+#define _PRUNER_SRC_PHASE_SCHEDULER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ir/ir.h"
+#include "pruner_util.h"
+
+namespace P4::ToZ3::Pruner {
+
+// A pruning phase that the scheduler may run several times.
+struct PrunePhase {
+    std::string name;
+    std::function<const IR::P4Program *(const IR::P4Program *)> run;
+    double seconds = 0;
+    uint64_t removed_chars = 0;
+    uint64_t runs = 0;
+    // The last run removed nothing and the program has not changed since.
+    bool stalled = false;
+};
+
+// The phases of the selected pruning mode, without the compiler passes.
+std::vector<PrunePhase> get_prune_phases(const PrunerConfig &pruner_conf);
+
+// Spends the budget of the pruner on the given phases. Every phase runs
+// once in order. After that, the phase that removed the most characters per
+// second so far runs next. Stops when the budget is spent or no phase makes
+// progress anymore. The program returned is always the best one found.
+const IR::P4Program *prune_within_budget(const IR::P4Program *program,
+                                         std::vector<PrunePhase> phases,
+                                         const PrunerConfig &pruner_conf);
+
+}  // namespace P4::ToZ3::Pruner
+
+#endif /* _PRUNER_SRC_PHASE_SCHEDULER_H */
@@ -0,0 +1,64 @@
+#include "progress.h"
+
+#include "contrib/json.h"
+#include "counter.h"
+#include "pruner_util.h"
+
+namespace P4::ToZ3::Pruner {
+
+ProgramSize measure_program(const IR::P4Program *program, uint64_t chars) {
+    Counter counter;
+    program->apply(counter);
+    ProgramSize size;
+    size.nodes = counter.nodes;
+    size.statements = counter.statements;
+    size.chars = chars;
+    return size;
+}
+
+void Progress::start(const IR::P4Program *program, uint64_t chars,
+                     const std::filesystem::path &log_file) {
+    initial = measure_program(program, chars);
+    current = initial;
+    start_time = std::chrono::steady_clock::now();
+    if (!log_file.empty()) {
+        log.open(log_file);
+    }
+}
+
+void Progress::accept(const IR::P4Program *program, uint64_t chars) {
+    current = measure_program(program, chars);
+}
+
+void Progress::record(bool accepted, bool cached) {
+    iteration++;
+    if (!log.is_open()) {
+        return;
+    }
+    nlohmann::json entry;
+    entry["iteration"] = iteration;
+    entry["phase"] = phase;
+    entry["accepted"] = accepted;
+    entry["cached"] = cached;
+    entry["oracle_calls"] = oracle_call_count();
+    entry["elapsed_s"] = elapsed_seconds();
+    entry["nodes"] = current.nodes;
+    entry["statements"] = current.statements;
+    entry["chars"] = current.chars;
+    entry["reduction_pct"] = reduction_pct();
+    log << entry.dump() << std::endl;
+}
+
+double Progress::reduction_pct() const {
+    if (initial.chars == 0) {
+        return 0;
+    }
+    double before_len = initial.chars;
+    return (before_len - current.chars) * (100.0 / before_len);
+}
+
+double Progress::elapsed_seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+}  // namespace P4::ToZ3::Pruner
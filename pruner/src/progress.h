@@ -0,0 +1,59 @@
+#ifndef _PRUNER_SRC_PROGRESS_H
+#define _PRUNER_SRC_PROGRESS_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "ir/ir.h"
+
+namespace P4::ToZ3::Pruner {
+
+struct ProgramSize {
+    uint64_t nodes = 0;
+    uint64_t statements = 0;
+    // The length of the program printed by ToP4.
+    uint64_t chars = 0;
+};
+
+// Tracks the size of the accepted program and reports the progress of the
+// pruner. Sizes are only measured when a candidate is accepted. The
+// character count is taken from the text that was already printed for the
+// candidate cache, so the program is never printed just to measure it.
+class Progress {
+ private:
+    ProgramSize initial;
+    ProgramSize current;
+    std::string phase = "setup";
+    uint64_t iteration = 0;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    // One JSON object per checked candidate, if requested.
+    std::ofstream log;
+
+ public:
+    static Progress &instance() {
+        static Progress instance;
+
+        return instance;
+    }
+    void start(const IR::P4Program *program, uint64_t chars,
+               const std::filesystem::path &log_file = {});
+    void set_phase(const std::string &new_phase) { phase = new_phase; }
+    // A candidate of the given length was accepted.
+    void accept(const IR::P4Program *program, uint64_t chars);
+    // Reports a checked candidate.
+    void record(bool accepted, bool cached);
+    const ProgramSize &get_initial() const { return initial; }
+    const ProgramSize &get_current() const { return current; }
+    // The reduction of the program so far, in percent of its characters.
+    double reduction_pct() const;
+    double elapsed_seconds() const;
+};
+
+ProgramSize measure_program(const IR::P4Program *program, uint64_t chars);
+
+}  // namespace P4::ToZ3::Pruner
+
+#endif /* _PRUNER_SRC_PROGRESS_H */
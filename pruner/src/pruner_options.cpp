@@ -1,5 +1,12 @@
 #include "pruner_options.h"
 
+#include <climits>
+#include <limits>
+#include <string>
+
+#include "lib/error.h"
+#include "toz3/compare/compare_options.h"
+
 namespace P4::ToZ3::Pruner {
 
 PrunerOptions::PrunerOptions() {
@@ -60,6 +67,97 @@ PrunerOptions::PrunerOptions() {
             return true;
         },
         "The name of the output file.");
+    registerOption(
+        "--progress", "file",
+        [this](const char *arg) {
+            progress_file = arg;
+            return true;
+        },
+        "Write one JSON object per checked candidate to this file, with the "
+        "phase, the oracle calls so far and the size of the program.");
+    registerOption(
+        "--jobs", "num",
+        [this](const char *arg) {
+            uint64_t value = 0;
+            if (!parse_count(arg, std::numeric_limits<uint64_t>::max(), &value) || value == 0) {
+                P4::error("Invalid number of jobs %s, expected a number of at least 1", arg);
+                return false;
+            }
+            jobs = value;
+            return true;
+        },
+        "Number of candidates generated per pruning round. They are checked "
+        "concurrently and the smallest passing one is kept. Defaults to 1.");
+    registerOption(
+        "--ddmin", nullptr,
+        [this](const char * /*arg*/) {
+            ddmin = true;
+            return true;
+        },
+        "Reduce statements with delta debugging instead of random sampling. "
+        "The result is 1-minimal with respect to single statements.");
+    registerOption(
+        "--hierarchical", nullptr,
+        [this](const char * /*arg*/) {
+            hierarchical = true;
+            return true;
+        },
+        "Prune coarse-to-fine until nothing changes: parsers and controls, "
+        "tables, actions, struct fields and blocks before statements and "
+        "expressions.");
+    registerOption(
+        "--slice", nullptr,
+        [this](const char * /*arg*/) {
+            slice = true;
+            return true;
+        },
+        "For validation bugs, first remove everything outside the backward "
+        "slice of the outputs the validator reports to diverge, in a single "
+        "candidate.");
+    registerOption(
+        "--compiler-spawner", nullptr,
+        [this](const char * /*arg*/) {
+            compiler_spawner = true;
+            return true;
+        },
+        "For crash bugs, spawn the compiler from a small helper process per job "
+        "instead of through popen and a shell.");
+    registerOption(
+        "--in-process", nullptr,
+        [this](const char * /*arg*/) {
+            in_process = true;
+            return true;
+        },
+        "Validate semantic bugs with the comparison library of the pruner. "
+        "Only the compiler dumps its passes in a subprocess, the validation "
+        "binary is not needed.");
+    registerOption(
+        "--max-oracle-calls", "num",
+        [this](const char *arg) {
+            if (!parse_count(arg, std::numeric_limits<uint64_t>::max(), &max_oracle_calls)) {
+                P4::error("Invalid number of oracle calls %s, expected a non-negative number",
+                          arg);
+                return false;
+            }
+            return true;
+        },
+        "Stop pruning after this many compiler or validator runs and emit the "
+        "smallest program found. Phases are then scheduled by their "
+        "reduction per second.");
+    registerOption(
+        "--time-budget", "seconds",
+        [this](const char *arg) {
+            // Oracle timeouts are passed on as unsigned seconds.
+            if (!parse_count(arg, UINT_MAX, &time_budget)) {
+                P4::error("Invalid time budget %s, expected a number of seconds between 0 and %s",
+                          arg, UINT_MAX);
+                return false;
+            }
+            return true;
+        },
+        "Stop pruning after this many seconds and emit the smallest program "
+        "found. Oracle runs are killed once the budget is spent. Phases are "
+        "then scheduled by their reduction per second.");
 
     registerOption(
         "--bug-type", "type",
@@ -1,6 +1,7 @@
 #ifndef _P4PRUNER_OPTIONS_H_
 #define _P4PRUNER_OPTIONS_H_
 
+#include <cstdint>
 #include <string>
 
 #include "frontends/common/options.h"
@@ -19,9 +20,20 @@ class PrunerOptions : public CompilerOptions {
     bool dry_run = false;
     bool do_rnd_prune = false;
     bool print_pruned = false;
+    // Candidates generated and checked concurrently per pruning round.
+    uint64_t jobs = 1;
+    bool ddmin = false;
+    bool hierarchical = false;
+    bool slice = false;
+    bool compiler_spawner = false;
+    bool in_process = false;
+    // Budgets across all phases, 0 means no limit.
+    uint64_t max_oracle_calls = 0;
+    uint64_t time_budget = 0;
     std::optional<std::string> seed;
     std::optional<std::string> bug_type = std::nullopt;
     std::optional<std::string> output_file = std::nullopt;
+    std::optional<std::string> progress_file = std::nullopt;
 };
 
 using P4PrunerContext = P4CContextWithOptions<PrunerOptions>;
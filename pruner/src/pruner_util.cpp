@@ -1,23 +1,35 @@
 #include "pruner_util.h"
 
 #include <sys/stat.h>
+#include <sys/types.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>  // IWYU pragma: keep
+#include <functional>
+#include <future>
+#include <optional>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <boost/random/uniform_int_distribution.hpp>
 
-#include "counter.h"
+#include "compiler_spawner.h"
+#include "progress.h"
 #include "frontends/p4/toP4/toP4.h"
 #include "lib/error.h"
 #include "toz3/pruner/src/constants.h"
+#include "validation_oracle.h"
 
 namespace P4::ToZ3::Pruner {
 
@@ -34,12 +46,56 @@ double PrunerRng::get_rnd_pct() {
     return distribution(instance().rng) / 100.0;
 }
 
+// Oracle runs may happen on the job threads of check_pruned_programs.
+static std::atomic<uint64_t> ORACLE_CALLS{0};
+
+uint64_t oracle_call_count() { return ORACLE_CALLS.load(); }
+
+void record_oracle_call() { ORACLE_CALLS++; }
+
+uint64_t remaining_oracle_calls(const PrunerConfig &pruner_conf) {
+    if (pruner_conf.max_oracle_calls == 0) {
+        return UINT64_MAX;
+    }
+    auto calls = oracle_call_count();
+    return calls >= pruner_conf.max_oracle_calls ? 0 : pruner_conf.max_oracle_calls - calls;
+}
+
+bool budget_exhausted(const PrunerConfig &pruner_conf) {
+    if (remaining_oracle_calls(pruner_conf) == 0) {
+        return true;
+    }
+    return pruner_conf.time_budget != 0 &&
+           Progress::instance().elapsed_seconds() >= static_cast<double>(pruner_conf.time_budget);
+}
+
+uint64_t oracle_timeout(const PrunerConfig &pruner_conf) {
+    if (pruner_conf.time_budget == 0) {
+        return 0;
+    }
+    auto remaining = static_cast<double>(pruner_conf.time_budget) -
+                     Progress::instance().elapsed_seconds();
+    return std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(remaining)));
+}
+
+std::string timeout_prefix(const PrunerConfig &pruner_conf) {
+    auto timeout = oracle_timeout(pruner_conf);
+    if (timeout == 0) {
+        return "";
+    }
+    return "timeout -s KILL " + std::to_string(timeout) + " ";
+}
+
 ExitInfo get_exit_info(const std::filesystem::path &file, const PrunerConfig &pruner_conf) {
     ExitInfo exit_info;
     INFO("Checking exit code.");
+    ORACLE_CALLS++;
 
-    if (pruner_conf.err_type == ErrorType::SemanticBug) {
-        std::string command = pruner_conf.validation_bin.value();
+    if (pruner_conf.err_type == ErrorType::SemanticBug && pruner_conf.in_process) {
+        exit_info = validate_in_process(file, pruner_conf);
+    } else if (pruner_conf.err_type == ErrorType::SemanticBug) {
+        std::string command = timeout_prefix(pruner_conf);
+        command += pruner_conf.validation_bin.value();
         command += " -i ";
         command += file;
         // set the output dir
@@ -83,12 +139,25 @@ std::pair<int, std::string> exec(std::string_view cmd) {
     return {pclose(pipe), output};
 }
 
+std::string get_include_dir() {
+    auto file_path = std::filesystem::path(__FILE__);
+    return file_path.parent_path().parent_path().parent_path() / "p4include";
+}
+
 ExitInfo get_crash_exit_info(const std::filesystem::path &file, const PrunerConfig &pruner_conf) {
     // The crash bugs variant of get_exit_code
+    auto &spawners = CompilerSpawnerPool::instance();
+    if (spawners.is_running()) {
+        auto exit_info = spawners.run(file, static_cast<uint32_t>(oracle_timeout(pruner_conf)));
+        if (exit_info.has_value()) {
+            return *exit_info;
+        }
+        INFO("Compiler spawner failed, falling back to popen.");
+    }
     ExitInfo exit_info;
-    auto file_path = std::filesystem::path(__FILE__);
-    std::string include_dir = file_path.parent_path().parent_path().parent_path() / "p4include";
-    std::string command = pruner_conf.compiler;
+    std::string include_dir = get_include_dir();
+    std::string command = timeout_prefix(pruner_conf);
+    command += pruner_conf.compiler;
     command += " --Wdisable -I" + include_dir + " ";
     command += file;
     // Apparently popen doesn't like stderr hence redirecting stderr to
@@ -134,61 +203,244 @@ void print_p4_program(const IR::P4Program *program) {
     program->apply(*print_p4);
 }
 
+std::string print_to_string(const IR::P4Program *program) {
+    std::stringstream prog_stream;
+    P4::ToP4 to_p4(&prog_stream, false);
+    program->apply(to_p4);
+    return prog_stream.str();
+}
+
 bool compare_files(const IR::P4Program *prog_before, const IR::P4Program *prog_after) {
-    auto *before_stream = new std::stringstream;
-    auto *after_stream = new std::stringstream;
+    return print_to_string(prog_before) == print_to_string(prog_after);
+}
+
+// A 128-bit digest of a ToP4 output, made of two independent 64-bit hashes.
+// Only the digest is kept, not the text of every candidate.
+struct TextDigest {
+    uint64_t first;
+    uint64_t second;
 
-    auto *before = new P4::ToP4(before_stream, false);
-    prog_before->apply(*before);
+    bool operator==(const TextDigest &other) const {
+        return first == other.first && second == other.second;
+    }
+};
 
-    auto *after = new P4::ToP4(after_stream, false);
-    prog_after->apply(*after);
+struct TextDigestHash {
+    size_t operator()(const TextDigest &digest) const { return digest.first; }
+};
 
-    return before_stream->str() == after_stream->str();
+static TextDigest digest_text(std::string_view text) {
+    // 64-bit FNV-1a next to the std::hash of the text.
+    uint64_t fnv = 0xcbf29ce484222325ULL;
+    for (auto chr : text) {
+        fnv ^= static_cast<unsigned char>(chr);
+        fnv *= 0x100000001b3ULL;
+    }
+    return {std::hash<std::string_view>{}(text), fnv};
 }
 
-double measure_size(const IR::P4Program *prog) {
-    auto *prog_stream = new std::stringstream;
-    auto *toP4 = new P4::ToP4(prog_stream, false);
-    prog->apply(*toP4);
-    return prog_stream->str().length();
+// The verdict of every candidate checked so far, keyed by the digest of its
+// ToP4 output. Candidates that print the same behave the same.
+static std::unordered_map<TextDigest, bool, TextDigestHash> CANDIDATE_VERDICTS;
+static uint64_t CACHED_VERDICTS = 0;
+
+// The accepted program and its ToP4 output.
+struct AcceptedProgram {
+    const IR::P4Program *program = nullptr;
+    std::string text;
+};
+static AcceptedProgram ACCEPTED;
+
+const std::string &get_accepted_text(const IR::P4Program *program) {
+    if (program != ACCEPTED.program) {
+        ACCEPTED.text = print_to_string(program);
+        ACCEPTED.program = program;
+    }
+    return ACCEPTED.text;
 }
 
-uint64_t count_statements(const IR::P4Program *prog) {
-    auto *counter = new Counter();
-    prog->apply(*counter);
-    return counter->statements;
+void set_accepted_text(const IR::P4Program *program, std::string text) {
+    ACCEPTED.text = std::move(text);
+    ACCEPTED.program = program;
 }
 
-double measure_pct(const IR::P4Program *prog_before, const IR::P4Program *prog_after) {
-    double before_len = measure_size(prog_before);
+uint64_t cached_verdict_count() { return CACHED_VERDICTS; }
+
+std::optional<bool> lookup_verdict(const std::string &candidate_text) {
+    auto verdict = CANDIDATE_VERDICTS.find(digest_text(candidate_text));
+    if (verdict == CANDIDATE_VERDICTS.end()) {
+        return std::nullopt;
+    }
+    CACHED_VERDICTS++;
+    return verdict->second;
+}
 
-    return (before_len - measure_size(prog_after)) * (100.0 / before_len);
+void write_candidate(const std::string &text, const std::filesystem::path &out_file) {
+    std::ofstream out(out_file);
+    out << text;
+}
+
+bool reproduces_bug(const ExitInfo &exit_info, const PrunerConfig &pruner_conf) {
+    // if got the right exit code and the right error type
+    // then the candidate still triggers the bug we are after
+    return exit_info.exit_code == pruner_conf.exit_code &&
+           classify_bug(exit_info) == pruner_conf.err_type;
 }
 
 int check_pruned_program(const IR::P4Program **orig_program, const IR::P4Program *pruned_program,
                          const PrunerConfig &pruner_conf) {
-    auto out_file =
-        pruner_conf.working_dir / pruner_conf.out_file_name.stem().replace_extension(".p4");
-
-    emit_p4_program(pruned_program, out_file);
-    if (compare_files(pruned_program, *orig_program)) {
+    if (budget_exhausted(pruner_conf)) {
+        INFO("Budget exhausted. Skipping analysis.");
+        return EXIT_FAILURE;
+    }
+    auto pruned_text = print_to_string(pruned_program);
+    const auto &orig_text = get_accepted_text(*orig_program);
+    if (pruned_text == orig_text) {
         INFO("File has not changed. Skipping analysis.");
         return EXIT_SUCCESS;
     }
-    ExitInfo exit_info = get_exit_info(out_file, pruner_conf);
-    int exit_code = exit_info.exit_code;
-    ErrorType err_type = classify_bug(exit_info);
-    // if got the right exit code and the right error type
-    // then modify the original program, if not
+    auto passed = lookup_verdict(pruned_text);
+    bool cached = passed.has_value();
+    if (cached) {
+        INFO("Candidate was already checked. Reusing the verdict.");
+    } else {
+        auto out_file =
+            pruner_conf.working_dir / pruner_conf.out_file_name.stem().replace_extension(".p4");
+        write_candidate(pruned_text, out_file);
+        passed = reproduces_bug(get_exit_info(out_file, pruner_conf), pruner_conf);
+        CANDIDATE_VERDICTS[digest_text(pruned_text)] = *passed;
+    }
+    // if the bug is still there modify the original program, if not
     // then choose a smaller bank of statements to remove now.
-    if (exit_code != pruner_conf.exit_code || err_type != pruner_conf.err_type) {
+    auto &progress = Progress::instance();
+    if (!*passed) {
+        progress.record(false, cached);
         INFO("FAILED");
         return EXIT_FAILURE;
     }
 
-    INFO("PASSED: Reduced by " << measure_pct(*orig_program, pruned_program) << " %")
+    double orig_len = orig_text.length();
+    INFO("PASSED: Reduced by " << (orig_len - pruned_text.length()) * (100.0 / orig_len) << " %")
     *orig_program = pruned_program;
+    progress.accept(pruned_program, pruned_text.length());
+    progress.record(true, cached);
+    set_accepted_text(pruned_program, std::move(pruned_text));
+    return EXIT_SUCCESS;
+}
+
+int check_pruned_programs(const IR::P4Program **orig_program,
+                          const std::vector<const IR::P4Program *> &candidates,
+                          const PrunerConfig &pruner_conf) {
+    if (candidates.size() == 1) {
+        return check_pruned_program(orig_program, candidates[0], pruner_conf);
+    }
+    if (budget_exhausted(pruner_conf)) {
+        INFO("Budget exhausted. Skipping analysis.");
+        return EXIT_FAILURE;
+    }
+    const auto &orig_text = get_accepted_text(*orig_program);
+    // Do not launch more oracle calls than the budget has left.
+    auto launchable = remaining_oracle_calls(pruner_conf);
+    // Printing the IR is not thread-safe, so all candidates are emitted up
+    // front. Only the external oracle runs concurrently.
+    struct Checked {
+        const IR::P4Program *program;
+        std::string text;
+        std::optional<bool> cached;
+        std::future<ExitInfo> verdict;
+        // In-process validation only dumps the passes concurrently, the
+        // comparisons are forked from this thread once all dumps are done.
+        std::future<DumpedPasses> passes;
+        DumpedPasses dumped;
+        pid_t comparison = -1;
+    };
+    bool in_process = pruner_conf.in_process && pruner_conf.err_type == ErrorType::SemanticBug;
+    std::vector<Checked> checked;
+    for (size_t idx = 0; idx < candidates.size(); ++idx) {
+        auto text = print_to_string(candidates[idx]);
+        if (text == orig_text) {
+            continue;
+        }
+        Checked entry{candidates[idx], std::move(text), {}, {}, {}, {}};
+        entry.cached = lookup_verdict(entry.text);
+        if (!entry.cached.has_value()) {
+            if (launchable == 0) {
+                continue;
+            }
+            launchable--;
+            auto job_conf = pruner_conf;
+            job_conf.working_dir = pruner_conf.working_dir / ("job_" + std::to_string(idx));
+            std::filesystem::create_directories(job_conf.working_dir);
+            auto out_file =
+                job_conf.working_dir / pruner_conf.out_file_name.stem().replace_extension(".p4");
+            write_candidate(entry.text, out_file);
+            if (in_process) {
+                record_oracle_call();
+                entry.passes = std::async(std::launch::async, [out_file, job_conf]() {
+                    return dump_passes(out_file, job_conf);
+                });
+            } else {
+                entry.verdict = std::async(std::launch::async, [out_file, job_conf]() {
+                    return get_exit_info(out_file, job_conf);
+                });
+            }
+        }
+        checked.push_back(std::move(entry));
+    }
+    if (checked.empty()) {
+        INFO("No candidate has changed. Skipping analysis.");
+        return EXIT_SUCCESS;
+    }
+    // Forking while other dumps are still running would copy the process in
+    // the middle of their work, so wait for all of them first.
+    for (auto &entry : checked) {
+        if (in_process && !entry.cached.has_value()) {
+            entry.dumped = entry.passes.get();
+        }
+    }
+    for (auto &entry : checked) {
+        if (in_process && !entry.cached.has_value() && !entry.dumped.compiler_exit.has_value()) {
+            entry.comparison = start_comparison(entry.dumped.passes, pruner_conf);
+        }
+    }
+    const Checked *best = nullptr;
+    for (auto &entry : checked) {
+        bool passed = false;
+        if (entry.cached.has_value()) {
+            passed = *entry.cached;
+        } else {
+            ExitInfo exit_info;
+            if (!in_process) {
+                exit_info = entry.verdict.get();
+            } else if (entry.dumped.compiler_exit.has_value()) {
+                exit_info = *entry.dumped.compiler_exit;
+            } else {
+                exit_info = finish_comparison(entry.comparison);
+            }
+            passed = reproduces_bug(exit_info, pruner_conf);
+            CANDIDATE_VERDICTS[digest_text(entry.text)] = passed;
+        }
+        if (passed && (best == nullptr || entry.text.length() < best->text.length())) {
+            best = &entry;
+        }
+    }
+    // One progress entry per candidate, the accepted one comes last.
+    auto &progress = Progress::instance();
+    for (const auto &entry : checked) {
+        if (&entry != best) {
+            progress.record(false, entry.cached.has_value());
+        }
+    }
+    if (best == nullptr) {
+        INFO("FAILED: none of " << checked.size() << " candidates passed");
+        return EXIT_FAILURE;
+    }
+    double orig_len = orig_text.length();
+    INFO("PASSED: Reduced by " << (orig_len - best->text.length()) * (100.0 / orig_len) << " %")
+    *orig_program = best->program;
+    progress.accept(best->program, best->text.length());
+    progress.record(true, best->cached.has_value());
+    set_accepted_text(best->program, best->text);
     return EXIT_SUCCESS;
 }
 }  // namespace P4::ToZ3::Pruner
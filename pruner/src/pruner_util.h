@@ -4,6 +4,9 @@
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <boost/random/mersenne_twister.hpp>
 
@@ -55,10 +58,47 @@ struct PrunerConfig {
     std::string err_string;
     bool allow_undef = false;
     ErrorType err_type = ErrorType::Unknown;
+    // The number of candidates checked concurrently per round.
+    uint64_t jobs = 1;
+    // Reduce statements with delta debugging instead of random sampling.
+    bool ddmin = false;
+    // Prune coarse-to-fine, from whole declarations down to expressions.
+    bool hierarchical = false;
+    // Remove what the diverging outputs of a semantic bug do not depend on.
+    bool slice = false;
+    // Validate semantic bugs with the comparison library instead of the
+    // validation script.
+    bool in_process = false;
+    // Stop checking candidates after this many oracle calls, 0 means no limit.
+    uint64_t max_oracle_calls = 0;
+    // Stop checking candidates after this many seconds, 0 means no limit.
+    uint64_t time_budget = 0;
     PrunerConfig() {}
 };
 
+// The number of times the compiler or validator was invoked so far.
+uint64_t oracle_call_count();
+// Counts an invocation of the compiler or validator made outside of
+// get_exit_info.
+void record_oracle_call();
+// The number of candidates answered from the verdict cache so far.
+uint64_t cached_verdict_count();
+
+// Whether the oracle call or the time budget of the pruner is spent.
+bool budget_exhausted(const PrunerConfig &pruner_conf);
+// The oracle calls that are left, without a limit this is UINT64_MAX.
+uint64_t remaining_oracle_calls(const PrunerConfig &pruner_conf);
+// The seconds a single oracle call may still take, 0 means no limit.
+uint64_t oracle_timeout(const PrunerConfig &pruner_conf);
+// Prefix for shell commands that kills them once the time budget is spent.
+std::string timeout_prefix(const PrunerConfig &pruner_conf);
+
+// Runs a shell command, returns its exit status and its standard output.
+std::pair<int, std::string> exec(std::string_view cmd);
+
 ExitInfo get_exit_info(const std::filesystem::path &file, const PrunerConfig &pruner_conf);
+// The P4 include directory passed to the compiler.
+std::string get_include_dir();
 ExitInfo get_crash_exit_info(const std::filesystem::path &file, const PrunerConfig &pruner_conf);
 
 ErrorType classify_bug(ExitInfo exit_info);
@@ -67,16 +107,22 @@ int get_exit_code(const std::filesystem::path &file, const PrunerConfig &pruner_
 void emit_p4_program(const IR::P4Program *program, const std::filesystem::path &prog_name);
 void print_p4_program(const IR::P4Program *program);
 
-bool compare_files(const IR::P4Program *prog_before, const IR::P4Program *prog_after);
-
-double measure_pct(const IR::P4Program *prog_before, const IR::P4Program *prog_after);
+std::string print_to_string(const IR::P4Program *program);
+// The ToP4 output of the program candidates are checked against. It is
+// printed once and reused until another program is accepted.
+const std::string &get_accepted_text(const IR::P4Program *program);
 
-double measure_size(const IR::P4Program *prog);
-
-uint64_t count_statements(const IR::P4Program *prog);
+bool compare_files(const IR::P4Program *prog_before, const IR::P4Program *prog_after);
 
 int check_pruned_program(const IR::P4Program **orig_program, const IR::P4Program *pruned_program,
                          const PrunerConfig &pruner_conf);
+
+// Checks all candidates concurrently, each in its own subdirectory of the
+// working directory, and keeps the smallest one that still triggers the bug.
+// Ties go to the earliest candidate so results only depend on the seed.
+int check_pruned_programs(const IR::P4Program **orig_program,
+                          const std::vector<const IR::P4Program *> &candidates,
+                          const PrunerConfig &pruner_conf);
 }  // namespace P4::ToZ3::Pruner
 
 #endif /* _PRUNER_UTIL_H_ */
@@ -0,0 +1,542 @@
+#include "slice_pruner.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hierarchical_pruner.h"
+#include "progress.h"
+#include "toz3/pruner/src/pruner_util.h"
+#include "validation_oracle.h"
+
+namespace P4::ToZ3::Pruner {
+
+namespace {
+
+// Methods of headers and stacks, they only change their target.
+const std::set<std::string> HEADER_METHODS = {"setValid", "setInvalid", "push_front",
+                                              "pop_front"};
+
+// Members of a stack whose element is only known at run time.
+const std::set<std::string> STACK_CURSORS = {"next", "last", "lastIndex"};
+
+// The member path an expression refers to and whether it stands for a
+// whole stack. Once an element is only known at run time, the path stops at
+// the stack, the members of that element are part of it.
+std::optional<std::pair<std::string, bool>> get_access_path(const IR::Expression *expr) {
+    if (const auto *path = expr->to<IR::PathExpression>()) {
+        return std::pair{std::string(path->path->name.name.c_str()), false};
+    }
+    if (const auto *member = expr->to<IR::Member>()) {
+        auto base = get_access_path(member->expr);
+        if (!base.has_value() || base->second) {
+            return base;
+        }
+        if (STACK_CURSORS.count(member->member.name.c_str()) != 0) {
+            return std::pair{base->first, true};
+        }
+        return std::pair{base->first + "." + member->member.name.c_str(), false};
+    }
+    if (const auto *index = expr->to<IR::ArrayIndex>()) {
+        auto base = get_access_path(index->left);
+        if (!base.has_value() || base->second) {
+            return base;
+        }
+        const auto *constant = index->right->to<IR::Constant>();
+        if (constant == nullptr) {
+            return std::pair{base->first, true};
+        }
+        return std::pair{base->first + "." + std::to_string(constant->asUnsigned()), false};
+    }
+    if (const auto *slice = expr->to<IR::Slice>()) {
+        return get_access_path(slice->e0);
+    }
+    return std::nullopt;
+}
+
+// The member path an expression refers to, such as "hdr.eth.dst". Stack
+// elements with a constant index are members, others stand for the stack.
+std::optional<std::string> get_path(const IR::Expression *expr) {
+    auto access_path = get_access_path(expr);
+    if (!access_path.has_value()) {
+        return std::nullopt;
+    }
+    return access_path->first;
+}
+
+// The indices an access path reads on the way to its location.
+std::vector<const IR::Expression *> get_indices(const IR::Expression *expr) {
+    std::vector<const IR::Expression *> indices;
+    while (expr != nullptr) {
+        if (const auto *member = expr->to<IR::Member>()) {
+            expr = member->expr;
+        } else if (const auto *index = expr->to<IR::ArrayIndex>()) {
+            indices.push_back(index->right);
+            expr = index->left;
+        } else if (const auto *slice = expr->to<IR::Slice>()) {
+            expr = slice->e0;
+        } else {
+            expr = nullptr;
+        }
+    }
+    return indices;
+}
+
+// Whether one location contains the other.
+bool overlaps(const std::string &left, const std::string &right) {
+    const auto &shorter = left.size() < right.size() ? left : right;
+    const auto &longer = left.size() < right.size() ? right : left;
+    return longer.compare(0, shorter.size(), shorter) == 0 &&
+           (longer.size() == shorter.size() || longer[shorter.size()] == '.');
+}
+
+// The top-level declaration a node belongs to, empty outside of one.
+std::string get_scope(const Visitor::Context *ctxt) {
+    std::string scope;
+    for (; ctxt != nullptr; ctxt = ctxt->parent) {
+        const auto *node = ctxt->node;
+        if (node->is<IR::P4Control>() || node->is<IR::P4Parser>() || node->is<IR::P4Action>() ||
+            node->is<IR::Function>()) {
+            scope = node->to<IR::IDeclaration>()->getName().name.c_str();
+        }
+    }
+    return scope;
+}
+
+// The parameter an argument binds to, nullptr if it can not be resolved.
+const IR::Parameter *get_parameter(const Callee *callee, const IR::Vector<IR::Argument> *args,
+                                   size_t idx) {
+    if (callee == nullptr) {
+        return nullptr;
+    }
+    const auto *arg = args->at(idx);
+    if (arg->name) {
+        return callee->params->getParameter(arg->name.name);
+    }
+    if (idx >= callee->params->size()) {
+        return nullptr;
+    }
+    return callee->params->getParameter(static_cast<unsigned>(idx));
+}
+
+bool writes_through(const IR::Parameter *param) {
+    return param->direction == IR::Direction::Out || param->direction == IR::Direction::InOut;
+}
+
+// Collects the locations an expression reads.
+class ReadCollector : public Inspector {
+ public:
+    explicit ReadCollector(std::string _scope) : scope(std::move(_scope)) {
+        setName("ReadCollector");
+    }
+    bool preorder(const IR::PathExpression *p) override { return !add(p); }
+    bool preorder(const IR::Member *m) override { return !add(m); }
+    bool preorder(const IR::ArrayIndex *a) override { return !add(a); }
+    bool preorder(const IR::Slice *s) override { return !add(s); }
+    std::vector<std::string> reads;
+
+ private:
+    std::string scope;
+    bool add(const IR::Expression *expr) {
+        auto path = get_path(expr);
+        if (!path.has_value()) {
+            return false;
+        }
+        reads.push_back(scope + "::" + *path);
+        for (const auto *index : get_indices(expr)) {
+            visit(index);
+        }
+        return true;
+    }
+};
+
+// Collects the local variables and the names that are still referenced.
+class LocalCollector : public Inspector {
+ public:
+    LocalCollector() { setName("LocalCollector"); }
+    bool preorder(const IR::PathExpression *p) override {
+        referenced.insert(p->path->name.name.c_str());
+        return false;
+    }
+    bool preorder(const IR::Declaration_Variable *d) override {
+        if (!get_scope(getContext()).empty()) {
+            locals.push_back(d);
+        }
+        return true;
+    }
+    std::set<std::string> referenced;
+    std::vector<const IR::Declaration_Variable *> locals;
+};
+
+// Removes the local variables that are no longer referenced by name.
+const IR::P4Program *remove_unused_locals(const IR::P4Program *program) {
+    auto *collector = new LocalCollector();
+    program->apply(*collector);
+    std::unordered_set<int> unused;
+    for (const auto *local : collector->locals) {
+        if (collector->referenced.count(local->name.name.c_str()) == 0) {
+            unused.insert(local->clone_id);
+        }
+    }
+    if (unused.empty()) {
+        return program;
+    }
+    auto *remover = new NodeRemover(unused);
+    return program->apply(*remover);
+}
+
+// The diverging outputs as locations of every block that has their root as
+// a parameter. Outputs are named by the parameters of their block.
+std::set<std::string> get_seed(const IR::P4Program *program,
+                               const std::vector<std::string> &outputs) {
+    std::set<std::string> seed;
+    for (const auto *object : program->objects) {
+        const IR::ParameterList *params = nullptr;
+        if (const auto *control = object->to<IR::P4Control>()) {
+            params = control->type->applyParams;
+        } else if (const auto *parser = object->to<IR::P4Parser>()) {
+            params = parser->type->applyParams;
+        } else {
+            continue;
+        }
+        std::string scope = object->to<IR::IDeclaration>()->getName().name.c_str();
+        for (const auto &output : outputs) {
+            auto root = output.substr(0, output.find('.'));
+            if (params->getParameter(cstring(root)) != nullptr) {
+                seed.insert(scope + "::" + output);
+            }
+        }
+    }
+    return seed;
+}
+
+}  // namespace
+
+bool CalleeCollector::preorder(const IR::P4Control *c) {
+    std::string name = c->name.name.c_str();
+    callees[name] = {c->type->applyParams, name};
+    return true;
+}
+
+bool CalleeCollector::preorder(const IR::P4Parser *p) {
+    std::string name = p->name.name.c_str();
+    callees[name] = {p->type->applyParams, name};
+    return true;
+}
+
+bool CalleeCollector::preorder(const IR::P4Action *a) {
+    std::string name = a->name.name.c_str();
+    auto scope = get_scope(getContext());
+    // Actions of a control share its scope.
+    if (scope.empty()) {
+        callees[name] = {a->parameters, name};
+    } else {
+        callees[scope + "::" + name] = {a->parameters, scope};
+    }
+    return false;
+}
+
+bool CalleeCollector::preorder(const IR::Function *f) {
+    std::string name = f->name.name.c_str();
+    callees[name] = {f->type->parameters, name};
+    return false;
+}
+
+bool CalleeCollector::preorder(const IR::Method *m) {
+    // Overloads are not told apart, the first one stands for all of them.
+    std::string name = m->name.name.c_str();
+    if (findContext<IR::Type_Extern>() != nullptr) {
+        name = "extern::" + name;
+    }
+    callees.emplace(name, Callee{m->type->parameters, ""});
+    return false;
+}
+
+bool CalleeCollector::preorder(const IR::Declaration_Instance *di) {
+    auto scope = get_scope(getContext());
+    if (const auto *type = di->type->to<IR::Type_Name>(); type != nullptr && !scope.empty()) {
+        instances[scope + "::" + di->name.name.c_str()] = type->path->name.name.c_str();
+    }
+    return false;
+}
+
+void CalleeCollector::end_apply() {
+    for (const auto &instance : instances) {
+        auto type = callees.find(instance.second);
+        if (type != callees.end() && !type->second.scope.empty()) {
+            callees[instance.first] = type->second;
+        }
+    }
+}
+
+Slicer::Slicer(const std::map<std::string, Callee> &_callees, std::set<std::string> *_relevant)
+    : callees(_callees), relevant(_relevant) {
+    setName("Slicer");
+}
+
+std::string Slicer::current_scope() const { return get_scope(getContext()); }
+
+const Callee *Slicer::find_callee(const IR::MethodCallExpression *mce) const {
+    auto lookup = [this](const std::string &key) -> const Callee * {
+        auto callee = callees.find(key);
+        return callee == callees.end() ? nullptr : &callee->second;
+    };
+    auto scope = current_scope();
+    if (const auto *path = mce->method->to<IR::PathExpression>()) {
+        std::string name = path->path->name.name.c_str();
+        if (const auto *callee = lookup(scope + "::" + name)) {
+            return callee;
+        }
+        return lookup(name);
+    }
+    if (const auto *member = mce->method->to<IR::Member>()) {
+        std::string name = member->member.name.c_str();
+        if (name == "apply") {
+            auto target = get_path(member->expr);
+            return target.has_value() ? lookup(scope + "::" + *target) : nullptr;
+        }
+        if (HEADER_METHODS.count(name) != 0) {
+            return nullptr;
+        }
+        return lookup("extern::" + name);
+    }
+    return nullptr;
+}
+
+bool Slicer::is_relevant(const std::string &location) const {
+    for (const auto &relevant_location : *relevant) {
+        if (overlaps(location, relevant_location)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Slicer::add_reads(const IR::Node *node) {
+    if (node == nullptr) {
+        return;
+    }
+    ReadCollector collector(current_scope());
+    node->apply(collector);
+    relevant->insert(collector.reads.begin(), collector.reads.end());
+}
+
+void Slicer::rebind(const std::string &from, const std::string &to) {
+    std::vector<std::string> rebound;
+    for (const auto &location : *relevant) {
+        if (!overlaps(location, from)) {
+            continue;
+        }
+        // A location that contains from is relevant as a whole.
+        rebound.push_back(location.size() > from.size() ? to + location.substr(from.size()) : to);
+    }
+    relevant->insert(rebound.begin(), rebound.end());
+}
+
+void Slicer::keep(const IR::Statement *s, const IR::Node *reads) {
+    kept.insert(s->clone_id);
+    add_reads(reads);
+    // The statement only runs under the conditions of its enclosing blocks.
+    for (const auto *ctxt = getContext(); ctxt != nullptr; ctxt = ctxt->parent) {
+        if (const auto *ifs = ctxt->node->to<IR::IfStatement>()) {
+            add_reads(ifs->condition);
+        } else if (const auto *sw = ctxt->node->to<IR::SwitchStatement>()) {
+            add_reads(sw->expression);
+        }
+    }
+}
+
+bool Slicer::preorder(const IR::AssignmentStatement *s) {
+    removable.insert(s->clone_id);
+    auto target = get_path(s->left);
+    if (!target.has_value() || is_relevant(current_scope() + "::" + *target)) {
+        keep(s, s->right);
+        for (const auto *index : get_indices(s->left)) {
+            add_reads(index);
+        }
+    }
+    return true;
+}
+
+bool Slicer::preorder(const IR::MethodCallStatement *s) {
+    const auto *mce = s->methodCall;
+    const auto *callee = find_callee(mce);
+    // Calls of actions, functions and controls are kept, their arguments
+    // are rebound when the call expression is visited.
+    if (callee != nullptr && !callee->scope.empty()) {
+        keep(s, nullptr);
+        return true;
+    }
+    auto scope = current_scope();
+    const auto *member = mce->method->to<IR::Member>();
+    std::optional<std::string> target;
+    if (member != nullptr) {
+        target = get_path(member->expr);
+    }
+    // Table applies and calls that can not be resolved.
+    if ((member != nullptr && member->member.name == "apply") ||
+        (!target.has_value() && callee == nullptr)) {
+        keep(s, s);
+        return true;
+    }
+    if (member != nullptr && HEADER_METHODS.count(member->member.name.c_str()) != 0) {
+        removable.insert(s->clone_id);
+        if (is_relevant(scope + "::" + *target)) {
+            keep(s, mce->arguments);
+        }
+        return true;
+    }
+    // Extern methods write the state of their instance, extern functions
+    // and both kinds of externs write their out and inout arguments.
+    bool has_writes = target.has_value();
+    bool writes_relevant = target.has_value() && is_relevant(scope + "::" + *target);
+    for (size_t idx = 0; idx < mce->arguments->size(); ++idx) {
+        const auto *param = get_parameter(callee, mce->arguments, idx);
+        if (param != nullptr && !writes_through(param)) {
+            continue;
+        }
+        has_writes = true;
+        auto arg_path = get_path(mce->arguments->at(idx)->expression);
+        writes_relevant =
+            writes_relevant || !arg_path.has_value() || is_relevant(scope + "::" + *arg_path);
+    }
+    // Externs such as verify only have side effects the slice can not see.
+    if (!has_writes) {
+        keep(s, s);
+        return true;
+    }
+    removable.insert(s->clone_id);
+    if (writes_relevant) {
+        keep(s, s);
+    }
+    return true;
+}
+
+bool Slicer::preorder(const IR::ReturnStatement *s) {
+    keep(s, s->expression);
+    return true;
+}
+
+bool Slicer::preorder(const IR::ExitStatement *s) {
+    keep(s, nullptr);
+    return true;
+}
+
+bool Slicer::preorder(const IR::Declaration_Variable *d) {
+    if (d->initializer != nullptr && is_relevant(current_scope() + "::" + d->name.name.c_str())) {
+        add_reads(d->initializer);
+    }
+    return true;
+}
+
+bool Slicer::preorder(const IR::MethodCallExpression *mce) {
+    const auto *callee = find_callee(mce);
+    if (callee == nullptr || callee->scope.empty()) {
+        return true;
+    }
+    auto scope = current_scope();
+    for (size_t idx = 0; idx < mce->arguments->size(); ++idx) {
+        const auto *param = get_parameter(callee, mce->arguments, idx);
+        if (param == nullptr) {
+            continue;
+        }
+        const auto *arg = mce->arguments->at(idx)->expression;
+        auto param_path = callee->scope + "::" + param->name.name.c_str();
+        auto arg_path = get_path(arg);
+        // The callee writes the argument through out and inout parameters.
+        if (arg_path.has_value() && writes_through(param)) {
+            rebind(scope + "::" + *arg_path, param_path);
+        }
+        // And reads it through all others.
+        if (param->direction == IR::Direction::Out || !is_relevant(param_path)) {
+            continue;
+        }
+        if (arg_path.has_value()) {
+            rebind(param_path, scope + "::" + *arg_path);
+            for (const auto *index : get_indices(arg)) {
+                add_reads(index);
+            }
+        } else {
+            add_reads(arg);
+        }
+    }
+    return true;
+}
+
+bool Slicer::preorder(const IR::SelectExpression *s) {
+    // Transitions decide which states run at all.
+    add_reads(s->select);
+    return true;
+}
+
+bool Slicer::preorder(const IR::P4Table *t) {
+    // Keys decide which action runs at all.
+    if (const auto *key = t->getKey()) {
+        for (const auto *key_element : key->keyElements) {
+            add_reads(key_element->expression);
+        }
+    }
+    return true;
+}
+
+const IR::P4Program *prune_slice(const IR::P4Program *program, const PrunerConfig &pruner_conf) {
+    INFO("\nPruning outside the slice of the diverging outputs");
+    Progress::instance().set_phase("slice");
+    if (budget_exhausted(pruner_conf)) {
+        return program;
+    }
+    auto calls_before = oracle_call_count();
+    auto slice_conf = pruner_conf;
+    slice_conf.working_dir = pruner_conf.working_dir / "slice";
+    std::filesystem::create_directories(slice_conf.working_dir);
+    auto source =
+        slice_conf.working_dir / pruner_conf.out_file_name.stem().replace_extension(".p4");
+    emit_p4_program(program, source);
+    auto outputs = find_diverging_outputs(source, slice_conf);
+    if (outputs.empty()) {
+        INFO("The validator did not report diverging outputs. Skipping the slice.");
+        return program;
+    }
+    for (const auto &output : outputs) {
+        INFO("Diverging output: " << output);
+    }
+    auto relevant = get_seed(program, outputs);
+    if (relevant.empty()) {
+        INFO("No block has the diverging outputs as parameters. Skipping the slice.");
+        return program;
+    }
+
+    auto *callee_collector = new CalleeCollector();
+    program->apply(*callee_collector);
+    // Repeat until the slice is closed, every step only adds locations.
+    Slicer *slicer = nullptr;
+    size_t relevant_before = 0;
+    do {
+        relevant_before = relevant.size();
+        slicer = new Slicer(callee_collector->callees, &relevant);
+        program->apply(*slicer);
+    } while (relevant.size() != relevant_before);
+
+    std::unordered_set<int> to_remove;
+    for (auto id : slicer->removable) {
+        if (slicer->kept.count(id) == 0) {
+            to_remove.insert(id);
+        }
+    }
+    INFO(to_remove.size() << " of " << slicer->removable.size()
+                          << " statements are outside the slice of " << relevant.size()
+                          << " locations");
+    if (!to_remove.empty()) {
+        auto *remover = new NodeRemover(to_remove);
+        const auto *candidate = remove_unused_locals(program->apply(*remover));
+        check_pruned_program(&program, candidate, pruner_conf);
+    }
+    INFO("Slicing used " << oracle_call_count() - calls_before << " oracle calls");
+    return program;
+}
+
+}  // namespace P4::ToZ3::Pruner
@@ -0,0 +1,82 @@
+#ifndef _SLICE_PRUNER_H
+#define _SLICE_PRUNER_H
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/node.h"
+#include "ir/visitor.h"
+#include "pruner_util.h"
+
+namespace P4::ToZ3::Pruner {
+
+// A callable with parameters: an action, function, control, parser or extern.
+struct Callee {
+    const IR::ParameterList *params = nullptr;
+    // The scope of the body, empty for externs which have none.
+    std::string scope;
+};
+
+// Collects the parameters of everything that can be called by name.
+class CalleeCollector : public Inspector {
+ public:
+    CalleeCollector() { setName("CalleeCollector"); }
+    bool preorder(const IR::P4Control *c) override;
+    bool preorder(const IR::P4Parser *p) override;
+    bool preorder(const IR::P4Action *a) override;
+    bool preorder(const IR::Function *f) override;
+    bool preorder(const IR::Method *m) override;
+    bool preorder(const IR::Declaration_Instance *di) override;
+    void end_apply() override;
+    std::map<std::string, Callee> callees;
+
+ private:
+    // Control and parser instances, resolved once all types are known.
+    std::map<std::string, std::string> instances;
+};
+
+// One step of a backward slice. Locations are member paths qualified with
+// the top-level declaration they belong to, such as "ingress::hdr.eth.dst".
+// Every architecture block is interpreted on its own, so a block is its own
+// scope. Paths are matched by prefix, so a write of "hdr.eth" affects
+// "hdr.eth.dst" and the other way around. Calls rebind paths between the
+// arguments and the parameters of the callee. Statements that write a
+// relevant location are kept and their reads become relevant, together
+// with the conditions they depend on. The slice is complete once a step
+// does not add a location anymore.
+class Slicer : public Inspector {
+ public:
+    Slicer(const std::map<std::string, Callee> &callees, std::set<std::string> *relevant);
+    bool preorder(const IR::AssignmentStatement *s) override;
+    bool preorder(const IR::MethodCallStatement *s) override;
+    bool preorder(const IR::ReturnStatement *s) override;
+    bool preorder(const IR::ExitStatement *s) override;
+    bool preorder(const IR::Declaration_Variable *d) override;
+    bool preorder(const IR::MethodCallExpression *mce) override;
+    bool preorder(const IR::SelectExpression *s) override;
+    bool preorder(const IR::P4Table *t) override;
+    // The clone ids of the statements the slice may drop and of those it keeps.
+    std::unordered_set<int> removable;
+    std::unordered_set<int> kept;
+
+ private:
+    const std::map<std::string, Callee> &callees;
+    std::set<std::string> *relevant;
+    std::string current_scope() const;
+    const Callee *find_callee(const IR::MethodCallExpression *mce) const;
+    bool is_relevant(const std::string &location) const;
+    void add_reads(const IR::Node *node);
+    void rebind(const std::string &from, const std::string &to);
+    void keep(const IR::Statement *s, const IR::Node *reads);
+};
+
+// Removes the statements and local declarations outside the backward slice
+// of the outputs the validator found to diverge, all in a single candidate.
+const IR::P4Program *prune_slice(const IR::P4Program *program, const PrunerConfig &pruner_conf);
+
+}  // namespace P4::ToZ3::Pruner
+
+#endif /* _SLICE_PRUNER_H */
@@ -1,30 +1,34 @@
 #include "statement_pruner.h"
 
 #include <algorithm>  // std::min
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <ostream>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
+#include "ddmin.h"
 #include "ir/indexed_vector.h"
+#include "progress.h"
 #include "toz3/pruner/src/constants.h"
 #include "toz3/pruner/src/pruner_util.h"
 
 namespace P4::ToZ3::Pruner {
 
-Pruner::Pruner(const std::vector<const IR::Statement *> &_to_prune) : to_prune(_to_prune) {
+Pruner::Pruner(const std::unordered_set<int> &_to_prune) : to_prune(_to_prune) {
     setName("Pruner");
 }
 
 const IR::Node *Pruner::preorder(IR::Statement *s) {
-    for (const auto &statement : to_prune) {
-        if (*statement == *s) {
-            // If the parent is an if statement, replace with an empty
-            // statement. This is needed to avoid assertion errors.
-            if (this->getParent<IR::IfStatement>() != nullptr) {
-                return new IR::EmptyStatement();
-            }
-            return nullptr;
+    if (to_prune.count(s->clone_id) != 0) {
+        // If the parent is an if statement, replace with an empty
+        // statement. This is needed to avoid assertion errors.
+        if (this->getParent<IR::IfStatement>() != nullptr) {
+            return new IR::EmptyStatement();
         }
+        return nullptr;
     }
     return s;
 }
@@ -54,10 +58,7 @@ Visitor::profile_t Collector::init_apply(const IR::Node *node) {
 }
 
 bool Collector::preorder(const IR::Statement *s) {
-    if (to_prune.size() <= max_statements && (PrunerRng::get_rnd_pct() < STATEMENT_PROB)) {
-        to_prune.push_back(s);
-    }
-
+    statements.push_back(s->clone_id);
     return true;
 }
 
@@ -68,35 +69,78 @@ bool Collector::preorder(const IR::BlockStatement *s) {
     return true;
 }
 
-std::vector<const IR::Statement *> collect_statements(const IR::P4Program *temp, int max) {
-    // An inspector that collects some statements at random.
-    auto *collector = new Collector(max);
-    temp->apply(*collector);
-    return collector->to_prune;
+const StatementCatalogue &get_catalogue(const IR::P4Program *program) {
+    // Only the catalogue of the latest accepted program is kept.
+    static StatementCatalogue catalogue;
+    if (catalogue.program != program) {
+        auto *collector = new Collector();
+        program->apply(*collector);
+        catalogue.program = program;
+        catalogue.ids = collector->statements;
+    }
+    return catalogue;
+}
+
+std::unordered_set<int> sample_statements(const StatementCatalogue &catalogue, uint64_t max) {
+    // Picks some statements at random, in program order.
+    std::unordered_set<int> to_prune;
+    for (auto id : catalogue.ids) {
+        if (to_prune.size() <= max && (PrunerRng::get_rnd_pct() < STATEMENT_PROB)) {
+            to_prune.insert(id);
+        }
+    }
+    return to_prune;
 }
 
 const IR::P4Program *remove_statements(const IR::P4Program *temp,
-                                       const std::vector<const IR::Statement *> &to_prune) {
-    // Removes all the nodes it receives from the vector.
+                                       const std::unordered_set<int> &to_prune) {
+    // Removes all the statements whose id is in the set.
     auto *pruner = new Pruner(to_prune);
     temp = temp->apply(*pruner);
     return temp;
 }
 
+const IR::P4Program *ddmin_statements(const IR::P4Program *program,
+                                      const PrunerConfig &pruner_conf) {
+    const auto &ids = get_catalogue(program).ids;
+    INFO("Delta debugging " << ids.size() << " statements");
+    std::function<bool(const std::vector<int> &)> try_removal =
+        [&program, &pruner_conf](const std::vector<int> &chunk) {
+            const auto *temp =
+                remove_statements(program, std::unordered_set<int>(chunk.begin(), chunk.end()));
+            return check_pruned_program(&program, temp, pruner_conf) == EXIT_SUCCESS;
+        };
+    auto needed =
+        ddmin(ids, try_removal, [&pruner_conf]() { return budget_exhausted(pruner_conf); });
+    INFO(needed.size() << " statements could not be removed individually");
+    return program;
+}
+
 const IR::P4Program *prune_statements(const IR::P4Program *program, PrunerConfig pruner_conf,
                                       uint64_t prog_size) {
+    auto calls_before = oracle_call_count();
+    if (pruner_conf.ddmin) {
+        INFO("\nPruning statements with delta debugging");
+        Progress::instance().set_phase("statements");
+        program = ddmin_statements(program, pruner_conf);
+        INFO("Statement pruning used " << oracle_call_count() - calls_before << " oracle calls");
+        return program;
+    }
     int same_before_pruning = 0;
     int result = 0;
     int max_statements = prog_size / STATEMENT_SIZE_BANK_RATIO;
 
     INFO("\nPruning statements");
-    for (int i = 0; i < PRUNER_MAX_ITERS; i++) {
+    Progress::instance().set_phase("statements");
+    for (int i = 0; i < PRUNER_MAX_ITERS && !budget_exhausted(pruner_conf); i++) {
         INFO("Trying with  " << max_statements << " statements");
-        const auto *temp = program;
-        std::vector<const IR::Statement *> to_prune = collect_statements(temp, max_statements);
-
-        temp = remove_statements(temp, to_prune);
-        result = check_pruned_program(&program, temp, pruner_conf);
+        // Every job draws its own bank, in order, so a seed fixes all of them.
+        std::vector<const IR::P4Program *> candidates;
+        for (uint64_t job = 0; job < pruner_conf.jobs; ++job) {
+            auto to_prune = sample_statements(get_catalogue(program), max_statements);
+            candidates.push_back(remove_statements(program, to_prune));
+        }
+        result = check_pruned_programs(&program, candidates, pruner_conf);
         if (result != EXIT_SUCCESS) {
             same_before_pruning++;
             max_statements = std::max(1, max_statements / AIMD_DECREASE);
@@ -110,6 +154,7 @@ const IR::P4Program *prune_statements(const IR::P4Program *program, PrunerConfig
         }
     }
     // Done pruning.
+    INFO("Statement pruning used " << oracle_call_count() - calls_before << " oracle calls");
     return program;
 }
 
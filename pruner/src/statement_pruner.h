@@ -2,6 +2,7 @@
 #ifndef _STATEMENT_PRUNER_H
 #define _STATEMENT_PRUNER_H
 #include <cstdint>
+#include <unordered_set>
 #include <vector>
 
 #include "ir/ir.h"
@@ -13,27 +14,36 @@ namespace P4::ToZ3::Pruner {
 
 class Pruner : public Transform {
  public:
-    const std::vector<const IR::Statement *> &to_prune;
-    explicit Pruner(const std::vector<const IR::Statement *> &to_prune);
+    // The clone ids of the statements to remove.
+    const std::unordered_set<int> &to_prune;
+    explicit Pruner(const std::unordered_set<int> &to_prune);
     const IR::Node *preorder(IR::Statement *s) override;
     const IR::Node *preorder(IR::ReturnStatement *s) override;
     const IR::Node *preorder(IR::BlockStatement *s) override;
     const IR::Node *preorder(IR::EmptyStatement *e) override;
 };
 
+// Collects the clone ids of all statements in program order.
 class Collector : public Inspector {
  public:
-    explicit Collector(uint64_t _max_statements) {
-        setName("Collector");
-        max_statements = _max_statements;
-    }
+    Collector() { setName("Collector"); }
     Visitor::profile_t init_apply(const IR::Node *node) override;
     bool preorder(const IR::Statement *s) override;
     bool preorder(const IR::BlockStatement *s) override;
-    std::vector<const IR::Statement *> to_prune;
-    uint64_t max_statements;
+    std::vector<int> statements;
 };
 
+// The statements of a program, identified by their clone id. Transforms keep
+// the clone id of the nodes they copy, so ids are stable across candidates
+// and removal is a set lookup instead of a structural comparison. Built
+// once per accepted program, sampling does not walk the IR.
+struct StatementCatalogue {
+    const IR::P4Program *program = nullptr;
+    std::vector<int> ids;
+};
+
+const StatementCatalogue &get_catalogue(const IR::P4Program *program);
+
 const IR::P4Program *prune_statements(const IR::P4Program *program, PrunerConfig pruner_conf,
                                       uint64_t prog_size);
 
@@ -0,0 +1,159 @@
+#include "validation_oracle.h"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "lib/compile_context.h"
+#include "pruner_options.h"
+#include "toz3/common/util.h"
+#include "toz3/compare/compare.h"
+
+namespace P4::ToZ3::Pruner {
+
+// The same passes the validation script dumps.
+static constexpr auto PASSES = "--top4 FrontEnd,MidEnd,PassManager";
+
+// Whether a line of the verbose compiler output names a dumped pass.
+static bool is_pass_name(const std::string &line) {
+    if (line.find("Writing program to") != std::string::npos) {
+        return false;
+    }
+    return line.find("FrontEnd") != std::string::npos ||
+           line.find("MidEnd") != std::string::npos ||
+           line.find("PassManager") != std::string::npos;
+}
+
+DumpedPasses dump_passes(const std::filesystem::path &file, const PrunerConfig &pruner_conf) {
+    auto dump_dir = pruner_conf.working_dir / "passes";
+    // Do not mix up the passes with those of an earlier candidate.
+    std::filesystem::remove_all(dump_dir);
+    std::filesystem::create_directories(dump_dir);
+
+    // A single compiler run dumps the passes and lists them in the order they
+    // ran, as p4validate does.
+    std::string command = timeout_prefix(pruner_conf);
+    command += pruner_conf.compiler.string() + " --Wdisable -v " + PASSES + " ";
+    command += "--dump " + dump_dir.string() + " ";
+    command += file.string() + " 2>&1";
+    auto dump_result = exec(command);
+    DumpedPasses dumped;
+    // A crash or an error of the compiler is the verdict, as it is for the
+    // validation script.
+    if (dump_result.first != 0) {
+        ExitInfo exit_info;
+        exit_info.exit_code = WIFSIGNALED(dump_result.first) ? 128 + WTERMSIG(dump_result.first)
+                                                             : WEXITSTATUS(dump_result.first);
+        exit_info.err_msg = dump_result.second;
+        dumped.compiler_exit = exit_info;
+        return dumped;
+    }
+
+    std::istringstream output(dump_result.second);
+    auto &passes = dumped.passes;
+    std::string pass;
+    while (std::getline(output, pass, '\n')) {
+        if (!is_pass_name(pass)) {
+            continue;
+        }
+        auto pass_path = dump_dir / (file.stem().string() + "-" + pass + ".p4");
+        // Passes that did not change the program do not need to be compared.
+        if (!passes.empty() && P4::ToZ3::compare_files(passes.back(), pass_path)) {
+            continue;
+        }
+        passes.push_back(pass_path);
+    }
+    return dumped;
+}
+
+pid_t start_comparison(const std::vector<std::filesystem::path> &passes,
+                       const PrunerConfig &pruner_conf,
+                       const std::filesystem::path &diverging_file) {
+    if (passes.size() < 2) {
+        return -1;
+    }
+    // Do not let the child print what is still buffered.
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+    // Keep the comparison output next to the passes instead of on our output.
+    auto log_file = passes.front().parent_path() / "compare.log";
+    int log_fd = open(log_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);  // NOLINT
+    if (log_fd >= 0) {
+        dup2(log_fd, STDOUT_FILENO);
+        dup2(log_fd, STDERR_FILENO);
+        close(log_fd);
+    }
+    // Do not let a slow comparison outlast the time budget.
+    alarm(static_cast<unsigned>(oracle_timeout(pruner_conf)));
+    // A fresh context, errors the pruner has seen must not fail the parser.
+    P4::AutoCompileContext compare_context(new P4PrunerContext);
+    auto &options = P4PrunerContext::get().options();
+    options.langVersion = P4::CompilerOptions::FrontendVersion::P4_16;
+    CompareConfig config;
+    config.allow_undefined = pruner_conf.allow_undef;
+    std::vector<DivergingOutput> diverging;
+    int result = process_programs(passes, &options, config, &diverging);
+    if (!diverging_file.empty()) {
+        std::ofstream out(diverging_file);
+        for (const auto &output : diverging) {
+            out << output.name << "\n";
+        }
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(result);
+}
+
+ExitInfo finish_comparison(pid_t pid) {
+    ExitInfo exit_info;
+    exit_info.exit_code = EXIT_SKIPPED;
+    int status = 0;
+    if (pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status)) {
+        exit_info.exit_code = WEXITSTATUS(status);
+    }
+    return exit_info;
+}
+
+ExitInfo validate_in_process(const std::filesystem::path &file, const PrunerConfig &pruner_conf) {
+    auto dumped = dump_passes(file, pruner_conf);
+    if (dumped.compiler_exit.has_value()) {
+        return *dumped.compiler_exit;
+    }
+    return finish_comparison(start_comparison(dumped.passes, pruner_conf));
+}
+
+std::vector<std::string> find_diverging_outputs(const std::filesystem::path &file,
+                                                const PrunerConfig &pruner_conf) {
+    auto diverging_file = pruner_conf.working_dir / "diverging.txt";
+    std::filesystem::remove(diverging_file);
+    record_oracle_call();
+    auto dumped = dump_passes(file, pruner_conf);
+    std::vector<std::string> names;
+    if (dumped.compiler_exit.has_value()) {
+        return names;
+    }
+    finish_comparison(start_comparison(dumped.passes, pruner_conf, diverging_file));
+    std::ifstream in(diverging_file);
+    std::string name;
+    while (std::getline(in, name)) {
+        // The same output may diverge in several pipes.
+        if (!name.empty() && std::find(names.begin(), names.end(), name) == names.end()) {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+}  // namespace P4::ToZ3::Pruner
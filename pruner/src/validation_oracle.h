@@ -0,0 +1,48 @@
+#ifndef _PRUNER_SRC_VALIDATION_ORACLE_H
+#define _PRUNER_SRC_VALIDATION_ORACLE_H
+
+#include <sys/types.h>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "pruner_util.h"
+
+namespace P4::ToZ3::Pruner {
+
+// The distinct passes dumped for a candidate.
+struct DumpedPasses {
+    std::vector<std::filesystem::path> passes;
+    // Set if the compiler failed on the candidate, this is then its verdict.
+    std::optional<ExitInfo> compiler_exit;
+};
+
+// Dumps the passes of the compiler for the candidate into the working
+// directory. Only runs subprocesses, so it is safe to call from several
+// threads.
+DumpedPasses dump_passes(const std::filesystem::path &file, const PrunerConfig &pruner_conf);
+
+// Compares the dumped passes with the comparison library. The interpreter
+// exits on programs it can not handle, so this runs in a forked copy of the
+// pruner and must be called from the main thread. A negative pid means
+// there was nothing to compare. If diverging_file is given, the child writes
+// the outputs that differ under the counterexample to it, one per line.
+pid_t start_comparison(const std::vector<std::filesystem::path> &passes,
+                       const PrunerConfig &pruner_conf,
+                       const std::filesystem::path &diverging_file = {});
+ExitInfo finish_comparison(pid_t pid);
+
+// Validates a candidate without the validation script.
+ExitInfo validate_in_process(const std::filesystem::path &file, const PrunerConfig &pruner_conf);
+
+// Validates a candidate in-process and returns the names of the outputs the
+// validator found to diverge, relative to their block, such as "hdr.eth.dst".
+// Empty if the comparison did not find a violation.
+std::vector<std::string> find_diverging_outputs(const std::filesystem::path &file,
+                                                const PrunerConfig &pruner_conf);
+
+}  // namespace P4::ToZ3::Pruner
+
+#endif /* _PRUNER_SRC_VALIDATION_ORACLE_H */
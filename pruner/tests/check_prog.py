@@ -33,6 +33,25 @@ def exec_process(cmd, *args, silent=False, **kwargs):
     return result
 
 
+def check_reduced(compiler_bin, p4_prog, pruned_file):
+    # Other strategies may end in a different minimum than the reference, so
+    # only check that the result is no larger and still crashes the compiler.
+    if not pruned_file.is_file():
+        log.error("Pruned file %s not found", pruned_file)
+        return EXIT_FAILURE
+    result = EXIT_SUCCESS
+    if pruned_file.stat().st_size > p4_prog.stat().st_size:
+        log.error("Pruned file %s is larger than the input", pruned_file)
+        result = EXIT_FAILURE
+    elif exec_process(f"{compiler_bin} {pruned_file}", silent=True).returncode == EXIT_SUCCESS:
+        log.error("Pruned file %s does not crash the compiler anymore", pruned_file)
+        result = EXIT_FAILURE
+    else:
+        log.info("Test passed")
+    pruned_file.unlink()
+    return result
+
+
 def main(args):
 
     compiler_bin = args.compiler.absolute()
@@ -56,7 +75,12 @@ def main(args):
     if not p4_prog.is_file():
         log.error("Please provide the path to a valid p4 program")
         return EXIT_FAILURE
-    prog_dir = p4_prog.parent.joinpath(f"pruned_{p4_prog.stem}")
+    # Runs with extra pruner flags get files of their own, so that they can
+    # run next to the default run of the same program.
+    suffix = "_".join(flag.strip("-") for flag in args.pruner_flags)
+    if suffix:
+        suffix = f"_{suffix}"
+    prog_dir = p4_prog.parent.joinpath(f"pruned_{p4_prog.stem}{suffix}")
 
     cmd_args = f"{pruner_bin} --seed {SEED} "
     cmd_args += f"--compiler-bin {compiler_bin} --bug-type {args.type} "
@@ -65,11 +89,19 @@ def main(args):
     if validation_bin:
         cmd_args += f"--validation-bin {validation_bin} "
 
+    if args.pruner_flags:
+        pruned_file = p4_prog.parent.joinpath(f"{p4_prog.stem}{suffix}_stripped.p4")
+        cmd_args += f"--output {pruned_file} "
+        cmd_args += " ".join(args.pruner_flags)
+
     pruner_result = exec_process(cmd_args)
 
     if pruner_result.returncode == EXIT_FAILURE:
         return EXIT_FAILURE
 
+    if args.pruner_flags:
+        return check_reduced(compiler_bin, p4_prog, pruned_file)
+
     PRUNED_FILE = pathlib.Path(str(p4_prog.with_suffix("")) + "_stripped.p4")
 
     FILE_NAME = p4_prog.parts[-1]
@@ -109,6 +141,11 @@ if __name__ == '__main__':
     parser.add_argument(
         "-t", "--type", dest='type', help="Validation or Crash bug [VALIDATION/CRASH]", required=True, choices=['VALIDATION', 'CRASH'])
 
+    parser.add_argument("-pf", "--pruner_flag", dest="pruner_flags", action="append",
+                        default=[], help="Pass a flag to the pruner, for example "
+                        "--pruner_flag=--ddmin. The result is then checked against "
+                        "the input instead of the reference file.")
+
     parser.add_argument("-l", "--log_file", dest="log_file",
                         default="pruner_test.log", help="Specifies name of the log file.")
 
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+""" Times p4validate on a P4 program under different flag configurations.
+    Example, comparing the default and the incremental solver on fabric.p4:
+    benchmark_validation.py -vb build/p4validate -c build/p4test \
+        -f="" -f="--incremental" pruner/example_programs/fabric/fabric.p4
+"""
+
+import argparse
+import sys
+import tempfile
+import time
+
+import util
+
+
+def run_config(args, flags):
+    times = []
+    returncode = util.EXIT_SUCCESS
+    for _ in range(args.repeat):
+        with tempfile.TemporaryDirectory() as dump_dir:
+            cmd = "%s " % args.validation_bin
+            cmd += "--dump-dir %s " % dump_dir
+            cmd += "--compiler-bin %s " % args.compiler
+            cmd += "%s %s" % (flags, args.p4_file)
+            start = time.perf_counter()
+            result = util.exec_process(cmd, silent=True)
+            times.append(time.perf_counter() - start)
+            returncode = result.returncode
+    return returncode, times
+
+
+def main(args):
+    configs = args.flags if args.flags else [""]
+    print("%-40s %8s %10s %10s" % ("flags", "exit", "min (s)", "mean (s)"))
+    for flags in configs:
+        returncode, times = run_config(args, flags)
+        print("%-40s %8d %10.3f %10.3f" %
+              (flags or "<default>", returncode, min(times), sum(times) / len(times)))
+    return util.EXIT_SUCCESS
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument("p4_file", type=lambda x: util.is_valid_file(parser, x),
+                        help="the p4 file to validate")
+    parser.add_argument("-vb", "--validation-bin", dest="validation_bin", required=True,
+                        type=lambda x: util.is_valid_file(parser, x),
+                        help="Specify the path to the p4validate binary.")
+    parser.add_argument("-c", "--compiler-bin", dest="compiler", required=True,
+                        type=lambda x: util.is_valid_file(parser, x),
+                        help="Specify the path to the compiler binary.")
+    parser.add_argument("-f", "--flags", action="append",
+                        help="A flag configuration to time, may be repeated.")
+    parser.add_argument("-r", "--repeat", type=int, default=3,
+                        help="How often each configuration is run.")
+    sys.exit(main(parser.parse_args()))
@@ -49,6 +49,7 @@ class Options():
         self.check_undefined = False    # Test must be sensitive to undefined behavior.
         self.disallow_undefined = False # Undefined violations must be detected.
         self.verbose = False            # Enable verbose output.
+        self.validation_flags = []      # Extra flags for the validation binary.
 
 
 def run_validation_test(options, target_dir, allow_undefined):
@@ -57,6 +58,8 @@ def run_validation_test(options, target_dir, allow_undefined):
     cmd += "--compiler-bin %s " % options.compiler_bin
     if allow_undefined:
         cmd += "--allow-undefined "
+    for flag in options.validation_flags:
+        cmd += "%s " % flag
     cmd += "%s " % options.p4_file
     result = util.exec_process(cmd)
     if options.verbose:
@@ -85,6 +88,8 @@ def run_violation_test(options, allow_undefined):
         cmd = "%s %s,%s " % (options.validation_bin, src_p4_file, p4_file)
         if allow_undefined:
             cmd += "--allow-undefined "
+        for flag in options.validation_flags:
+            cmd += "%s " % flag
         result = util.exec_process(cmd).returncode
         if result != util.EXIT_VIOLATION:
             return util.EXIT_FAILURE
@@ -145,6 +150,9 @@ if __name__ == '__main__':
                         help="If active, the test must produce a violation error. Also p4_file must be an input folder.")
     parser.add_argument("-cu", "--check-undefined", action="store_true",
                         help="If active, the test must not produce a violation error if allow-undefined is true. Otherwise, it must throw an error.")
+    parser.add_argument("-vf", "--validation-flag", dest="validation_flags", action="append",
+                        default=[], help="Pass a flag to the validation binary, "
+                        "for example --validation-flag=--packed-validity.")
     args, argv = parser.parse_known_args()
     options = Options()
     options.rootdir = util.is_valid_file(parser, args.rootdir)
@@ -157,6 +165,7 @@ if __name__ == '__main__':
     options.check_undefined = args.check_undefined
     options.disallow_undefined = args.disallow_undefined
     options.verbose = args.verbose
+    options.validation_flags = args.validation_flags
     options.cleanupTmp = args.nocleanup
 
     # All args after '--' are intended for the p4 compiler
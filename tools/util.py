@@ -9,6 +9,7 @@ EXIT_FAILURE = 1
 EXIT_SKIPPED = 10
 EXIT_VIOLATION = 20
 EXIT_UNDEF = 30
+EXIT_UNKNOWN = 40
 
 def rm_tree(pth: Path):
     for child in pth.iterdir():
@@ -14,6 +14,7 @@
 #include "lib/cstring.h"
 #include "lib/error.h"
 #include "options.h"
+#include "serve.h"
 
 using namespace P4::literals;
 
@@ -28,26 +29,34 @@ static constexpr auto SEC_TO_MS = 1000000.0;
 
 namespace P4::ToZ3 {
 
+// Whether a line of the verbose compiler output names a pass.
+bool isPassName(const std::string &line) {
+    if (line.find("Writing program to") != std::string::npos) {
+        return false;
+    }
+    return line.find("FrontEnd") != std::string::npos ||
+           line.find("MidEnd") != std::string::npos ||
+           line.find("PassManager") != std::string::npos;
+}
+
 std::vector<std::filesystem::path> generatePassList(const fs::path &p4_file,
                                                     const fs::path &dump_dir,
                                                     const fs::path &compiler_bin) {
+    // A single compiler run dumps the passes and lists them in the order they
+    // ran, a second run would double the compile time of every job.
     std::string cmd = compiler_bin;
     // FIXME: use absl::StrConcat
-    cmd += " " + std::string(PASSES) + " ";
+    cmd += " --Wdisable -v " + std::string(PASSES) + " ";
     cmd += std::string("--dump ") + dump_dir + " " + p4_file.c_str();
     cmd += " 2>&1";
     std::stringstream output;
     exec(cstring(cmd), output);
     std::vector<std::filesystem::path> passList;
-    std::string cmd1 = compiler_bin.c_str();
-    cmd1 += cstring(" --Wdisable  -v ") + p4_file.c_str();
-    cmd1 += " 2>&1 ";
-    cmd1 += "| sed -e '/FrontEnd\\|MidEnd\\|PassManager/!d' | ";
-    cmd1 += "sed -e '/Writing program to/d' ";
-    std::stringstream passes;
-    exec(cstring(cmd1), passes);
     std::string pass;
-    while (std::getline(passes, pass, '\n')) {
+    while (std::getline(output, pass, '\n')) {
+        if (!isPassName(pass)) {
+            continue;
+        }
         cstring passPath(
             (dump_dir / (cstring(p4_file.stem().c_str()) + "-" + pass + ".p4").c_str()).c_str());
         passList.emplace_back(passPath.c_str());
@@ -83,7 +92,7 @@ int validateTranslation(const fs::path &p4_file, const fs::path &dump_dir,
         std::cerr << "P4 file did not generate enough passes." << std::endl;
         return EXIT_SKIPPED;
     }
-    int result = process_programs(progList, options, options->undefined_is_ok);
+    int result = process_programs(progList, options, options->compare_config);
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
     auto timeElapsed =
         std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / SEC_TO_MS;
@@ -99,7 +108,7 @@ int main(int argc, char *const argv[]) {
     options.langVersion = P4::CompilerOptions::FrontendVersion::P4_16;
     options.compilerVersion = "p4toz3 test"_cs;
 
-    if (options.process(argc, argv) != nullptr) {
+    if (options.process(argc, argv) != nullptr && options.serve_dir == nullptr) {
         options.setInputFile();
     }
     if (P4::errorCount() > 0) {
@@ -109,13 +118,19 @@ int main(int argc, char *const argv[]) {
     // Initialize our logger
     P4::ToZ3::Logger::init();
 
-    auto p4File = fs::path(options.file.c_str());
-    auto dumpDir = options.dump_dir != nullptr ? fs::path(options.dump_dir.c_str()) : DUMP_DIR;
-    dumpDir = dumpDir / p4File.filename().stem();
-    fs::create_directories(dumpDir);
+    auto dumpRoot = options.dump_dir != nullptr ? fs::path(options.dump_dir.c_str()) : DUMP_DIR;
     auto compilerBin =
         options.compiler_bin != nullptr ? fs::path(options.compiler_bin.c_str()) : COMPILER_BIN;
     P4::ToZ3::Logger::log_msg(0, "Using the compiler binary %s.", compilerBin);
 
-    return P4::ToZ3::validateTranslation(p4File, dumpDir, compilerBin, &options);
+    auto validate = [&](const fs::path &p4File) {
+        auto dumpDir = dumpRoot / p4File.filename().stem();
+        fs::create_directories(dumpDir);
+        return P4::ToZ3::validateTranslation(p4File, dumpDir, compilerBin, &options);
+    };
+    if (options.serve_dir != nullptr) {
+        return P4::ToZ3::serve_spool_dir(fs::path(options.serve_dir.c_str()),
+                                         options.serve_workers, validate);
+    }
+    return validate(fs::path(options.file.c_str()));
 }
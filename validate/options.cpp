@@ -1,5 +1,12 @@
 #include "options.h"
 
+#include <functional>
+#include <limits>
+#include <utility>
+
+#include "lib/error.h"
+#include "toz3/compare/compare_options.h"
+
 namespace P4::ToZ3 {
 
 ValidateOptions::ValidateOptions() {
@@ -18,12 +25,32 @@ ValidateOptions::ValidateOptions() {
         },
         "Specifies the binary to compile a p4 file.");
     registerOption(
-        "--allow-undefined", nullptr,
-        [this](const char * /*arg*/) {
-            undefined_is_ok = true;
+        "--serve", "folder",
+        [this](const char *arg) {
+            serve_dir = cstring(arg);
+            return true;
+        },
+        "Keep running and validate every P4 file that is dropped into this spool "
+        "folder. Write jobs under a hidden name (.name.p4) and rename them into "
+        "place when complete. Results are written to its results subfolder. "
+        "Create a file named STOP in the folder to shut down.");
+    registerOption(
+        "--workers", "num",
+        [this](const char *arg) {
+            if (!parse_count(arg, std::numeric_limits<uint64_t>::max(), &serve_workers)) {
+                P4::error("Invalid number of workers %s", arg);
+                return false;
+            }
             return true;
         },
-        "Toggle to tolerate undefined behavior in comparison.");
+        "Number of programs validated concurrently in serve mode. "
+        "Defaults to one per core.");
+    register_compare_options(
+        [this](const char *option, const char *arg_name,
+               std::function<bool(const char *)> processor, const char *description) {
+            registerOption(option, arg_name, std::move(processor), description);
+        },
+        &compare_config);
 }
 
 }  // namespace P4::ToZ3
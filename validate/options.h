@@ -1,8 +1,11 @@
 #ifndef TOZ3_VALIDATE_OPTIONS_H_
 #define TOZ3_VALIDATE_OPTIONS_H_
 
+#include <cstdint>
+
 #include "frontends/common/parser_options.h"
 #include "lib/cstring.h"
+#include "toz3/compare/compare.h"
 
 namespace P4::ToZ3 {
 
@@ -16,8 +19,12 @@ class ValidateOptions : public ParserOptions {
     cstring compiler_bin;
     // Where the intermediate files are going to be dumped.
     cstring dump_dir;
-    // Toggle this to allow differences in undefined behavior.
-    bool undefined_is_ok = false;
+    // Settings for the program comparison.
+    CompareConfig compare_config;
+    // Serve validation jobs from this spool directory instead of a single file.
+    cstring serve_dir;
+    // Number of programs validated concurrently in serve mode, 0 uses one per core.
+    uint64_t serve_workers = 0;
 };
 
 using P4toZ3Context = P4CContextWithOptions<ValidateOptions>;
@@ -0,0 +1,182 @@
+#include "serve.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>  // IWYU pragma: keep
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../common/util.h"
+
+namespace P4::ToZ3 {
+
+namespace fs = std::filesystem;
+
+static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(20);
+static constexpr auto STOP_FILE = "STOP";
+
+namespace {
+
+struct RunningJob {
+    fs::path p4_file;
+    std::chrono::steady_clock::time_point start;
+};
+
+const char *get_status(int exit_code) {
+    switch (exit_code) {
+        case EXIT_SUCCESS:
+            return "passed";
+        case EXIT_VIOLATION:
+            return "violation";
+        case EXIT_UNDEF:
+            return "undefined";
+        case EXIT_SKIPPED:
+            return "skipped";
+        case EXIT_UNKNOWN:
+            return "unknown";
+        default:
+            return "error";
+    }
+}
+
+std::string json_escape(const std::string &str) {
+    std::string escaped;
+    for (auto chr : str) {
+        auto code = static_cast<unsigned char>(chr);
+        if (chr == '"' || chr == '\\') {
+            escaped += '\\';
+            escaped += chr;
+        } else if (code < 0x20) {
+            // Control characters may only appear as escapes in JSON strings.
+            std::array<char, 7> unicode{};
+            std::snprintf(unicode.data(), unicode.size(), "\\u%04x", code);
+            escaped += unicode.data();
+        } else {
+            escaped += chr;
+        }
+    }
+    return escaped;
+}
+
+void write_result(const fs::path &result_file, const fs::path &p4_file, int exit_code,
+                  int signal, double seconds) {
+    std::ofstream result(result_file);
+    result << "{\"program\": \"" << json_escape(p4_file.filename()) << "\", ";
+    result << "\"status\": \"" << (signal != 0 ? "crashed" : get_status(exit_code)) << "\", ";
+    result << "\"exit_code\": " << exit_code << ", ";
+    result << "\"signal\": " << signal << ", ";
+    result << "\"seconds\": " << seconds << "}\n";
+}
+
+// Returns the pending jobs in the spool directory, oldest name first. Hidden
+// files are jobs that are still being written.
+std::vector<fs::path> collect_jobs(const fs::path &spool_dir) {
+    std::vector<fs::path> jobs;
+    for (const auto &entry : fs::directory_iterator(spool_dir)) {
+        auto name = entry.path().filename().string();
+        if (entry.is_regular_file() && entry.path().extension() == ".p4" && name[0] != '.') {
+            jobs.push_back(entry.path());
+        }
+    }
+    std::sort(jobs.begin(), jobs.end());
+    return jobs;
+}
+
+[[noreturn]] void run_worker(const fs::path &p4_file, const fs::path &log_file,
+                             const ValidateFn &validate) {
+    if (std::freopen(log_file.c_str(), "w", stdout) == nullptr ||
+        std::freopen(log_file.c_str(), "a", stderr) == nullptr) {
+        _exit(EXIT_FAILURE);
+    }
+    int result = validate(p4_file);
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    _exit(result);
+}
+
+}  // namespace
+
+int serve_spool_dir(const fs::path &spool_dir, uint64_t num_workers, const ValidateFn &validate) {
+    auto running_dir = spool_dir / "running";
+    auto done_dir = spool_dir / "done";
+    auto result_dir = spool_dir / "results";
+    fs::create_directories(running_dir);
+    fs::create_directories(done_dir);
+    fs::create_directories(result_dir);
+    if (num_workers == 0) {
+        num_workers = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    Logger::log_msg(0, "Serving jobs from %s with %s workers.", spool_dir, num_workers);
+
+    // Workers are forked processes. The P4C compile context and the IR are
+    // process-global, so every job gets a private copy of both, as well as
+    // its own Z3 context, without paying for a fresh process start.
+    std::map<pid_t, RunningJob> workers;
+    uint64_t finished = 0;
+    while (true) {
+        int status = 0;
+        pid_t pid = 0;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            auto it = workers.find(pid);
+            if (it == workers.end()) {
+                continue;
+            }
+            const auto &job = it->second;
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - job.start;
+            int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+            int signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+            auto stem = job.p4_file.stem();
+            write_result(result_dir / stem.concat(".json"), job.p4_file, exit_code, signal,
+                         elapsed.count());
+            std::error_code ec;
+            fs::rename(job.p4_file, done_dir / job.p4_file.filename(), ec);
+            workers.erase(it);
+            finished++;
+        }
+
+        auto jobs = collect_jobs(spool_dir);
+        for (const auto &job : jobs) {
+            if (workers.size() >= num_workers) {
+                break;
+            }
+            // Claim the job by moving it out of the spool directory.
+            auto claimed = running_dir / job.filename();
+            std::error_code ec;
+            fs::rename(job, claimed, ec);
+            if (ec) {
+                continue;
+            }
+            auto log_file = result_dir / claimed.stem().concat(".log");
+            pid = fork();
+            if (pid == 0) {
+                run_worker(claimed, log_file, validate);
+            }
+            if (pid < 0) {
+                std::cerr << "Failed to fork a worker for " << claimed << std::endl;
+                fs::rename(claimed, job, ec);
+                break;
+            }
+            workers.emplace(pid, RunningJob{claimed, std::chrono::steady_clock::now()});
+        }
+
+        if (workers.empty() && jobs.empty() && fs::exists(spool_dir / STOP_FILE)) {
+            break;
+        }
+        std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+    Logger::log_msg(0, "Served %s jobs.", finished);
+    return EXIT_SUCCESS;
+}
+
+}  // namespace P4::ToZ3
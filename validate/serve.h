@@ -0,0 +1,25 @@
+#ifndef TOZ3_VALIDATE_SERVE_H_
+#define TOZ3_VALIDATE_SERVE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+
+namespace P4::ToZ3 {
+
+// Validates a single program and returns the exit code of the validation.
+using ValidateFn = std::function<int(const std::filesystem::path &)>;
+
+// Serve validation jobs from a spool directory until a STOP file appears and
+// all jobs are drained. Every *.p4 file in the spool directory is a job.
+// Clients write a job under a hidden name, such as .name.p4, and rename it
+// into place once complete, so a job is never picked up half-written. A job
+// is moved to running/ while a worker validates it and to done/ afterwards.
+// The outcome is written to results/<name>.json and the output of the
+// worker to results/<name>.log. A num_workers of 0 uses one per core.
+int serve_spool_dir(const std::filesystem::path &spool_dir, uint64_t num_workers,
+                    const ValidateFn &validate);
+
+}  // namespace P4::ToZ3
+
+#endif  // TOZ3_VALIDATE_SERVE_H_